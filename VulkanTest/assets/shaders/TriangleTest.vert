@@ -6,6 +6,15 @@ layout(binding = 0) uniform UniformBufferObject {
 	mat4 proj;
 } ubo;
 
+layout(push_constant) uniform DrawPushConstants {
+	vec4 positionOffset;
+	vec4 positionScale;
+	mat4 transform;
+} pc;
+
+// Set when the vertices use the packed format with octahedral encoded normals
+layout(constant_id = 0) const bool c_OctahedralNormals = false;
+
 layout(location = 0) in vec3 a_Position;
 layout(location = 1) in vec3 a_Normal;
 layout(location = 2) in vec3 a_Color;
@@ -15,9 +24,18 @@ layout(location = 0) out vec3 v_Normal;
 layout(location = 1) out vec3 v_Color;
 layout(location = 2) out vec2 v_TexCoord;
 
+vec3 OctahedralDecode(vec2 e) {
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+	return normalize(n);
+}
+
 void main() {
-	gl_Position = ubo.proj * ubo.view * ubo.model * vec4(a_Position, 1.0);
-	v_Normal = a_Normal;
+	vec3 position = a_Position * pc.positionScale.xyz + pc.positionOffset.xyz;
+	gl_Position = ubo.proj * ubo.view * ubo.model * pc.transform * vec4(position, 1.0);
+	v_Normal = c_OctahedralNormals ? OctahedralDecode(a_Normal.xy) : a_Normal;
 	v_Color = a_Color;
 	v_TexCoord = a_TexCoord;
 }
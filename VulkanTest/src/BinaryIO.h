@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Span.h"
+
+class BinaryWriter
+{
+public:
+    BinaryWriter() = default;
+
+    const std::vector<uint8_t>& GetBuffer() const { return mBuffer; }
+    size_t GetSize() const { return std::size(mBuffer); }
+
+    template<typename T>
+    void Write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(&value, sizeof(T));
+    }
+
+    template<typename T>
+    void WriteArray(Span<const T> values, size_t alignment = alignof(T))
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Align(alignment);
+        WriteBytes(std::data(values), values.size_bytes());
+    }
+
+    void WriteString(const std::string& str)
+    {
+        Write((uint32_t)std::size(str));
+        WriteBytes(std::data(str), std::size(str));
+    }
+
+    void WriteBytes(const void* data, size_t size)
+    {
+        const size_t offset = std::size(mBuffer);
+        mBuffer.resize(offset + size);
+        if (size > 0)
+            memcpy(std::data(mBuffer) + offset, data, size);
+    }
+
+    void Align(size_t alignment)
+    {
+        const size_t remainder = std::size(mBuffer) % alignment;
+        if (remainder != 0)
+            mBuffer.resize(std::size(mBuffer) + alignment - remainder, 0);
+    }
+
+    template<typename T>
+    void Overwrite(size_t offset, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        memcpy(std::data(mBuffer) + offset, &value, sizeof(T));
+    }
+
+private:
+    std::vector<uint8_t> mBuffer;
+};
+
+class BinaryReader
+{
+public:
+    BinaryReader(Span<const uint8_t> data) : mData(data) {}
+
+    size_t GetOffset() const { return mOffset; }
+    bool IsAtEnd() const { return mOffset == std::size(mData); }
+
+    template<typename T>
+    T Read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value;
+        memcpy(&value, ReadBytes(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    // Returns a view into the underlying data, nothing is copied.
+    template<typename T>
+    Span<const T> ReadArray(size_t count, size_t alignment = alignof(T))
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        Align(alignment);
+        if (count > (std::size(mData) - mOffset) / sizeof(T))
+            throw std::runtime_error("Unexpected end of binary data");
+
+        const T* values = (const T*)ReadBytes(count * sizeof(T));
+        return { values, count };
+    }
+
+    std::string ReadString()
+    {
+        const auto length = Read<uint32_t>();
+        const char* chars = (const char*)ReadBytes(length);
+        return std::string(chars, length);
+    }
+
+    const uint8_t* ReadBytes(size_t size)
+    {
+        if (size > std::size(mData) - mOffset)
+            throw std::runtime_error("Unexpected end of binary data");
+
+        const uint8_t* bytes = std::data(mData) + mOffset;
+        mOffset += size;
+        return bytes;
+    }
+
+    void Align(size_t alignment)
+    {
+        const size_t remainder = mOffset % alignment;
+        if (remainder != 0)
+            ReadBytes(alignment - remainder);
+    }
+
+private:
+    Span<const uint8_t> mData;
+    size_t mOffset = 0;
+};
@@ -0,0 +1,411 @@
+#include "BlockCompression.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define BLOCK_COMPRESSION_SSE 1
+#   include <emmintrin.h>
+#else
+#   define BLOCK_COMPRESSION_SSE 0
+#endif
+
+#include <stb_dxt.h>
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace BlockCompression
+{
+    namespace
+    {
+        constexpr uint32_t BlockPixels = 16;
+        constexpr uint32_t BytesPerPixel = 4;
+
+        // BC7 interpolation weights for 4-bit indices, out of 64
+        constexpr int Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // A mode 6 endpoint, 7 bits per channel plus a shared lowest bit
+        struct Bc7Endpoint
+        {
+            uint8_t value[4] = {};
+            uint8_t pbit = 0;
+
+            int Expand(int channel) const { return (value[channel] << 1) | pbit; }
+        };
+
+        // The 16 interpolated colors of a block, one array per channel
+        struct Bc7Palette
+        {
+            alignas(16) float channel[4][16];
+        };
+
+        class BitWriter
+        {
+        public:
+            void Write(uint64_t value, uint32_t count)
+            {
+                const uint32_t word = mPos / 64;
+                const uint32_t shift = mPos % 64;
+                mBits[word] |= value << shift;
+                if (shift + count > 64)
+                    mBits[word + 1] |= value >> (64 - shift);
+                mPos += count;
+            }
+
+            void CopyTo(uint8_t* dst) const { memcpy(dst, mBits, sizeof(mBits)); }
+
+        private:
+            uint64_t mBits[2] = {};
+            uint32_t mPos = 0;
+        };
+
+        // Picks the 7-bit values and p-bit that reproduce the color best
+        Bc7Endpoint QuantizeEndpoint(const float color[4])
+        {
+            Bc7Endpoint best;
+            float bestError = std::numeric_limits<float>::max();
+            for (uint8_t pbit = 0; pbit < 2; ++pbit)
+            {
+                Bc7Endpoint endpoint;
+                endpoint.pbit = pbit;
+                float error = 0.0f;
+                for (int c = 0; c < 4; ++c)
+                {
+                    const float target = std::clamp(color[c], 0.0f, 255.0f);
+                    endpoint.value[c] = (uint8_t)std::clamp((int)std::lround((target - pbit) * 0.5f), 0, 127);
+                    const float diff = endpoint.Expand(c) - target;
+                    error += diff * diff;
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    best = endpoint;
+                }
+            }
+            return best;
+        }
+
+        void BuildPalette(const Bc7Endpoint& e0, const Bc7Endpoint& e1, Bc7Palette& palette)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                for (int i = 0; i < 16; ++i)
+                    palette.channel[c][i] = float(((64 - Bc7Weights[i]) * e0.Expand(c) + Bc7Weights[i] * e1.Expand(c) + 32) >> 6);
+            }
+        }
+
+        // Closest palette color for every pixel, returns the total squared error
+        float SelectIndices(const float (&pixels)[BlockPixels][4], const Bc7Palette& palette, uint8_t (&indices)[BlockPixels])
+        {
+            float totalError = 0.0f;
+            for (uint32_t p = 0; p < BlockPixels; ++p)
+            {
+#if BLOCK_COMPRESSION_SSE
+                __m128 errors[4];
+                for (int k = 0; k < 4; ++k)
+                {
+                    errors[k] = _mm_setzero_ps();
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        const __m128 diff = _mm_sub_ps(_mm_load_ps(&palette.channel[c][k * 4]), _mm_set1_ps(pixels[p][c]));
+                        errors[k] = _mm_add_ps(errors[k], _mm_mul_ps(diff, diff));
+                    }
+                }
+
+                __m128 minError = _mm_min_ps(_mm_min_ps(errors[0], errors[1]), _mm_min_ps(errors[2], errors[3]));
+                minError = _mm_min_ps(minError, _mm_shuffle_ps(minError, minError, _MM_SHUFFLE(2, 3, 0, 1)));
+                minError = _mm_min_ps(minError, _mm_shuffle_ps(minError, minError, _MM_SHUFFLE(1, 0, 3, 2)));
+
+                // The first entry equal to the minimum, ties go to the lower index like the scalar loop
+                for (int k = 0; k < 4; ++k)
+                {
+                    const int mask = _mm_movemask_ps(_mm_cmpeq_ps(errors[k], minError));
+                    if (mask != 0)
+                    {
+                        int lane = 0;
+                        while (!(mask & (1 << lane)))
+                            ++lane;
+                        indices[p] = uint8_t(k * 4 + lane);
+                        break;
+                    }
+                }
+                totalError += _mm_cvtss_f32(minError);
+#else
+                float bestError = std::numeric_limits<float>::max();
+                for (uint8_t i = 0; i < 16; ++i)
+                {
+                    float error = 0.0f;
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        const float diff = palette.channel[c][i] - pixels[p][c];
+                        error += diff * diff;
+                    }
+                    if (error < bestError)
+                    {
+                        bestError = error;
+                        indices[p] = i;
+                    }
+                }
+                totalError += bestError;
+#endif
+            }
+            return totalError;
+        }
+
+        // Least squares endpoints for the chosen indices, false when all pixels use the same weight
+        bool RefitEndpoints(const float (&pixels)[BlockPixels][4], const uint8_t (&indices)[BlockPixels], float (&e0)[4], float (&e1)[4])
+        {
+            float a = 0.0f, b = 0.0f, c = 0.0f;
+            float x0[4] = {};
+            float x1[4] = {};
+            for (uint32_t p = 0; p < BlockPixels; ++p)
+            {
+                const float w = Bc7Weights[indices[p]] / 64.0f;
+                a += (1.0f - w) * (1.0f - w);
+                b += (1.0f - w) * w;
+                c += w * w;
+                for (int ch = 0; ch < 4; ++ch)
+                {
+                    x0[ch] += (1.0f - w) * pixels[p][ch];
+                    x1[ch] += w * pixels[p][ch];
+                }
+            }
+
+            const float det = a * c - b * b;
+            if (std::abs(det) < 1e-6f)
+                return false;
+
+            for (int ch = 0; ch < 4; ++ch)
+            {
+                e0[ch] = (c * x0[ch] - b * x1[ch]) / det;
+                e1[ch] = (a * x1[ch] - b * x0[ch]) / det;
+            }
+            return true;
+        }
+
+        void WriteBc7Mode6(Bc7Endpoint e0, Bc7Endpoint e1, uint8_t (&indices)[BlockPixels], uint8_t* dst)
+        {
+            // The first pixel's index is stored with its top bit implied zero, swapping the endpoints inverts the indices
+            if (indices[0] >= 8)
+            {
+                std::swap(e0, e1);
+                for (auto& index : indices)
+                    index = uint8_t(15 - index);
+            }
+
+            BitWriter writer;
+            writer.Write(1 << 6, 7);
+            for (int c = 0; c < 4; ++c)
+            {
+                writer.Write(e0.value[c], 7);
+                writer.Write(e1.value[c], 7);
+            }
+            writer.Write(e0.pbit, 1);
+            writer.Write(e1.pbit, 1);
+            writer.Write(indices[0], 3);
+            for (uint32_t p = 1; p < BlockPixels; ++p)
+                writer.Write(indices[p], 4);
+            writer.CopyTo(dst);
+        }
+
+        void EncodeBc7Block(const uint8_t* block, uint8_t* dst)
+        {
+            float pixels[BlockPixels][4];
+            float mean[4] = {};
+            for (uint32_t p = 0; p < BlockPixels; ++p)
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    pixels[p][c] = block[p * BytesPerPixel + c];
+                    mean[c] += pixels[p][c] / BlockPixels;
+                }
+            }
+
+            // Principal axis of the colors by power iteration on their covariance
+            float covariance[4][4] = {};
+            for (uint32_t p = 0; p < BlockPixels; ++p)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    for (int j = 0; j < 4; ++j)
+                        covariance[i][j] += (pixels[p][i] - mean[i]) * (pixels[p][j] - mean[j]);
+                }
+            }
+
+            float axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+            for (int iteration = 0; iteration < 8; ++iteration)
+            {
+                float next[4] = {};
+                float length = 0.0f;
+                for (int i = 0; i < 4; ++i)
+                {
+                    for (int j = 0; j < 4; ++j)
+                        next[i] += covariance[i][j] * axis[j];
+                    length = std::max(length, std::abs(next[i]));
+                }
+                if (length < 1e-6f)
+                    break;
+                for (int i = 0; i < 4; ++i)
+                    axis[i] = next[i] / length;
+            }
+
+            float axisLengthSq = 0.0f;
+            for (int c = 0; c < 4; ++c)
+                axisLengthSq += axis[c] * axis[c];
+
+            float tMin = 0.0f;
+            float tMax = 0.0f;
+            for (uint32_t p = 0; p < BlockPixels; ++p)
+            {
+                float t = 0.0f;
+                for (int c = 0; c < 4; ++c)
+                    t += (pixels[p][c] - mean[c]) * axis[c];
+                t /= axisLengthSq;
+                tMin = std::min(tMin, t);
+                tMax = std::max(tMax, t);
+            }
+
+            float end0[4];
+            float end1[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                end0[c] = mean[c] + axis[c] * tMin;
+                end1[c] = mean[c] + axis[c] * tMax;
+            }
+
+            Bc7Endpoint e0 = QuantizeEndpoint(end0);
+            Bc7Endpoint e1 = QuantizeEndpoint(end1);
+            Bc7Palette palette;
+            BuildPalette(e0, e1, palette);
+            uint8_t indices[BlockPixels];
+            float error = SelectIndices(pixels, palette, indices);
+
+            // One refinement step, kept only when it lowers the error
+            if (error > 0.0f && RefitEndpoints(pixels, indices, end0, end1))
+            {
+                const Bc7Endpoint refit0 = QuantizeEndpoint(end0);
+                const Bc7Endpoint refit1 = QuantizeEndpoint(end1);
+                BuildPalette(refit0, refit1, palette);
+                uint8_t refitIndices[BlockPixels];
+                const float refitError = SelectIndices(pixels, palette, refitIndices);
+                if (refitError < error)
+                {
+                    e0 = refit0;
+                    e1 = refit1;
+                    std::copy(std::begin(refitIndices), std::end(refitIndices), std::begin(indices));
+                }
+            }
+
+            WriteBc7Mode6(e0, e1, indices, dst);
+        }
+
+        void EncodeBlock(const uint8_t* block, VkFormat format, uint8_t* dst)
+        {
+            switch (format)
+            {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+                stb_compress_dxt_block(dst, block, 0, STB_DXT_HIGHQUAL);
+                break;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+                stb_compress_dxt_block(dst, block, 1, STB_DXT_HIGHQUAL);
+                break;
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            {
+                uint8_t rg[BlockPixels * 2];
+                for (uint32_t p = 0; p < BlockPixels; ++p)
+                {
+                    rg[p * 2] = block[p * BytesPerPixel];
+                    rg[p * 2 + 1] = block[p * BytesPerPixel + 1];
+                }
+                stb_compress_bc5_block(dst, rg);
+                break;
+            }
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                EncodeBc7Block(block, dst);
+                break;
+            default:
+                throw std::invalid_argument("Unsupported block compression format");
+            }
+        }
+    }
+
+    bool IsBlockCompressed(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    uint32_t GetBlockSize(VkFormat format)
+    {
+        switch (format)
+        {
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            return 8;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16;
+        default:
+            return BytesPerPixel;
+        }
+    }
+
+    uint64_t GetImageSize(VkFormat format, uint32_t width, uint32_t height)
+    {
+        if (!IsBlockCompressed(format))
+            return uint64_t(width) * height * BytesPerPixel;
+        return uint64_t((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+    }
+
+    void CompressImage(const uint8_t* pixels, uint32_t width, uint32_t height, VkFormat format, uint8_t* dst)
+    {
+        const uint32_t blocksX = (width + 3) / 4;
+        const uint32_t blocksY = (height + 3) / 4;
+        const uint32_t blockSize = GetBlockSize(format);
+
+        ThreadPool::Get().ParallelFor(blocksY, [&](size_t blockY) {
+            uint8_t block[BlockPixels * BytesPerPixel];
+            for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+            {
+                for (uint32_t y = 0; y < 4; ++y)
+                {
+                    const uint32_t srcY = std::min(uint32_t(blockY) * 4 + y, height - 1);
+                    for (uint32_t x = 0; x < 4; ++x)
+                    {
+                        const uint32_t srcX = std::min(blockX * 4 + x, width - 1);
+                        memcpy(block + (y * 4 + x) * BytesPerPixel, pixels + (size_t(srcY) * width + srcX) * BytesPerPixel, BytesPerPixel);
+                    }
+                }
+
+                EncodeBlock(block, format, dst + (blockY * blocksX + blockX) * blockSize);
+            }
+        });
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+// CPU encoders for the BC texture formats. BC1, BC3 and BC5 blocks come from stb_dxt, BC7 blocks are
+// encoded in mode 6 (one subset, RGBA endpoints) with an SSE palette search.
+namespace BlockCompression
+{
+    bool IsBlockCompressed(VkFormat format);
+
+    // Bytes per 4x4 block, or per pixel for uncompressed RGBA8
+    uint32_t GetBlockSize(VkFormat format);
+    uint64_t GetImageSize(VkFormat format, uint32_t width, uint32_t height);
+
+    // Encodes an RGBA8 image into 4x4 blocks of a BC1, BC3, BC5 or BC7 format. Blocks past the
+    // right and bottom edges repeat the edge pixels. Rows of blocks are encoded in parallel on the thread pool.
+    // BC5 encodes the red and green channels only.
+    void CompressImage(const uint8_t* pixels, uint32_t width, uint32_t height, VkFormat format, uint8_t* dst);
+}
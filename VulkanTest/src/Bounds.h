@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/glm.hpp>
+
+// Axis aligned box plus a bounding sphere around the box center
+struct Bounds
+{
+    glm::vec3 min{ 0.0f };
+    glm::vec3 max{ 0.0f };
+    glm::vec3 center{ 0.0f };
+    float radius = 0.0f;
+
+    static Bounds FromMinMax(const glm::vec3& min, const glm::vec3& max)
+    {
+        Bounds bounds;
+        bounds.min = min;
+        bounds.max = max;
+        bounds.center = (min + max) * 0.5f;
+        bounds.radius = glm::length(max - min) * 0.5f;
+        return bounds;
+    }
+
+    // Box enclosing both, with a sphere that encloses both spheres
+    static Bounds Merge(const Bounds& a, const Bounds& b)
+    {
+        Bounds bounds = FromMinMax(glm::min(a.min, b.min), glm::max(a.max, b.max));
+        bounds.radius = std::max(glm::length(a.center - bounds.center) + a.radius,
+            glm::length(b.center - bounds.center) + b.radius);
+        return bounds;
+    }
+
+    // Box around the transformed box. Assumes an affine transform.
+    Bounds Transform(const glm::mat4& m) const
+    {
+        glm::vec3 newMin(m[3]);
+        glm::vec3 newMax(m[3]);
+        for (int col = 0; col < 3; ++col)
+        {
+            const glm::vec3 a = glm::vec3(m[col]) * min[col];
+            const glm::vec3 b = glm::vec3(m[col]) * max[col];
+            newMin += glm::min(a, b);
+            newMax += glm::max(a, b);
+        }
+
+        // The box center maps to the new box center, so both spheres share it and the smaller one is kept
+        Bounds bounds = FromMinMax(newMin, newMax);
+        bounds.radius = std::min(bounds.radius, radius * GetMaxScale(m));
+        return bounds;
+    }
+
+    static float GetMaxScale(const glm::mat4& m)
+    {
+        return std::sqrt(std::max({ glm::dot(glm::vec3(m[0]), glm::vec3(m[0])),
+            glm::dot(glm::vec3(m[1]), glm::vec3(m[1])), glm::dot(glm::vec3(m[2]), glm::vec3(m[2])) }));
+    }
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// Per draw data pushed to TriangleTest.vert
+struct DrawPushConstants
+{
+    alignas(16) glm::vec4 positionOffset{ 0.0f };
+    alignas(16) glm::vec4 positionScale{ 1.0f };
+    // World transform of the mesh instance
+    alignas(16) glm::mat4 transform{ 1.0f };
+};
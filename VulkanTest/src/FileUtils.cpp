@@ -2,6 +2,8 @@
 #include "FileUtils.h"
 
 #include "StringUtils.h"
+#include "MappedFile.h"
+#include "HashUtils.h"
 #include <fstream>
 #include <iostream>
 
@@ -36,4 +38,29 @@ namespace FileUtils
         file.close();
         return lines;
     }
+
+    bool GetFileStats(const std::filesystem::path& filepath, uint64_t& size, int64_t& writeTime)
+    {
+        std::error_code ec;
+        size = (uint64_t)std::filesystem::file_size(filepath, ec);
+        if (ec)
+            return false;
+
+        const auto time = std::filesystem::last_write_time(filepath, ec);
+        if (ec)
+            return false;
+
+        writeTime = (int64_t)time.time_since_epoch().count();
+        return true;
+    }
+
+    bool HashFile(const std::filesystem::path& filepath, uint64_t& hash)
+    {
+        const auto file = MappedFile::Open(filepath);
+        if (!file)
+            return false;
+
+        hash = HashUtils::Hash64(file->GetData(), file->GetSize());
+        return true;
+    }
 }
@@ -4,10 +4,17 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <cstdint>
 
 namespace FileUtils
 {
     std::vector<char> ReadFile(const std::filesystem::path& filepath);
 
     std::vector<std::string> ReadLines(const std::filesystem::path& filepath);
+
+    // Size and last write time, used to tell whether files derived from a source are out of date
+    bool GetFileStats(const std::filesystem::path& filepath, uint64_t& size, int64_t& writeTime);
+
+    // Hash of the whole file contents, catches changes that keep the size and write time
+    bool HashFile(const std::filesystem::path& filepath, uint64_t& hash);
 }
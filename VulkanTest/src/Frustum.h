@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+// View frustum planes in the space the matrix transforms from, with normals pointing inside
+struct Frustum
+{
+    std::array<glm::vec4, 6> planes;
+
+    // Expects a clip space with depth from zero to one
+    static Frustum FromMatrix(const glm::mat4& m)
+    {
+        const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+        const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+        const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+        const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+        Frustum frustum;
+        frustum.planes = { row3 + row0, row3 - row0, row3 + row1, row3 - row1, row2, row3 - row2 };
+        for (auto& plane : frustum.planes)
+            plane /= glm::length(glm::vec3(plane));
+        return frustum;
+    }
+
+    bool IsVisible(const Bounds& bounds) const
+    {
+        for (const auto& plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane), bounds.center) + plane.w < -bounds.radius)
+                return false;
+        }
+        return true;
+    }
+};
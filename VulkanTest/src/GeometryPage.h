@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Vertex.h"
+#include "Bounds.h"
+
+// A chunk of one mesh's triangles with its own vertices, the unit that is streamed in and out.
+// Every page fits in the same fixed size slot so GPU memory can be handed out without fragmenting.
+struct GeometryPage
+{
+    static constexpr uint32_t MaxVertices = 4096;
+    static constexpr uint32_t MaxIndices = 8192 * 3;
+
+    std::vector<Vertex> vertices;
+    // Indices into the page's own vertices
+    std::vector<uint16_t> indices;
+
+    size_t GetMemorySize() const { return std::size(vertices) * sizeof(Vertex) + std::size(indices) * sizeof(uint16_t); }
+};
+
+// Page table entry, everything needed to decide whether a page is wanted without reading it
+struct GeometryPageInfo
+{
+    uint64_t dataOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;
+    uint32_t meshIndex = 0;
+    uint32_t materialIndex = 0;
+    Bounds bounds;
+
+    size_t GetDataSize() const { return size_t(vertexCount) * sizeof(Vertex) + size_t(indexCount) * sizeof(uint16_t); }
+};
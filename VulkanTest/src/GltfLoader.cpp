@@ -0,0 +1,546 @@
+#include "GltfLoader.h"
+
+#include "Model.h"
+#include "MappedFile.h"
+#include "BinaryIO.h"
+#include "Json.h"
+#include "ThreadPool.h"
+#include "VertexUtils.h"
+#include "Log.h"
+
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    constexpr uint32_t GlbMagic = 0x46546c67; // "glTF"
+    constexpr uint32_t GlbVersion = 2;
+    constexpr uint32_t GlbJsonChunk = 0x4e4f534a; // "JSON"
+    constexpr uint32_t GlbBinChunk = 0x004e4942; // "BIN"
+
+    constexpr uint32_t ComponentUnsignedByte = 5121;
+    constexpr uint32_t ComponentUnsignedShort = 5123;
+    constexpr uint32_t ComponentUnsignedInt = 5125;
+    constexpr uint32_t ComponentFloat = 5126;
+
+    constexpr uint32_t PrimitiveTriangles = 4;
+
+    struct GlbHeader
+    {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t length = 0;
+    };
+
+    struct GlbChunkHeader
+    {
+        uint32_t length = 0;
+        uint32_t type = 0;
+    };
+
+    // Valid glTF that uses something this loader doesn't handle, as opposed to a broken file
+    struct UnsupportedError : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    struct Accessor
+    {
+        const uint8_t* data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        uint32_t componentType = 0;
+        uint32_t componentCount = 0;
+        bool normalized = false;
+    };
+
+    // A primitive's geometry, either views into the mapped file or converted copies
+    struct PrimitiveData
+    {
+        Span<const Vertex> vertexView;
+        std::vector<Vertex> vertices;
+
+        bool indicesInPlace = false;
+        Span<const uint8_t> indexView;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+        std::vector<uint32_t> indices;
+
+        bool hasBounds = false;
+        Bounds bounds;
+    };
+
+    uint32_t GetComponentCount(const std::string& type)
+    {
+        if (type == "SCALAR")
+            return 1;
+        if (type == "VEC2")
+            return 2;
+        if (type == "VEC3")
+            return 3;
+        if (type == "VEC4")
+            return 4;
+        throw UnsupportedError("Accessor type " + type);
+    }
+
+    size_t GetComponentSize(uint32_t componentType)
+    {
+        switch (componentType)
+        {
+        case 5120:
+        case ComponentUnsignedByte:
+            return 1;
+        case 5122:
+        case ComponentUnsignedShort:
+            return 2;
+        case ComponentUnsignedInt:
+        case ComponentFloat:
+            return 4;
+        default:
+            throw std::runtime_error("Invalid accessor component type");
+        }
+    }
+
+    Accessor GetAccessor(const JsonValue& doc, Span<const uint8_t> bin, uint32_t index)
+    {
+        const auto& accessor = doc["accessors"][index];
+        if (!accessor.IsObject())
+            throw std::runtime_error("Invalid accessor index");
+        if (accessor.HasMember("sparse"))
+            throw UnsupportedError("Sparse accessors");
+        if (!accessor.HasMember("bufferView"))
+            throw UnsupportedError("Accessors without a buffer view");
+
+        const auto& view = doc["bufferViews"][accessor["bufferView"].GetUint(~0u)];
+        if (!view.IsObject())
+            throw std::runtime_error("Invalid buffer view index");
+        if (view["buffer"].GetUint(~0u) != 0)
+            throw UnsupportedError("Buffers other than the GLB binary chunk");
+
+        Accessor result;
+        result.componentType = accessor["componentType"].GetUint();
+        result.componentCount = GetComponentCount(accessor["type"].GetString());
+        result.normalized = accessor["normalized"].GetBool();
+        result.count = accessor["count"].GetUint();
+
+        const size_t elementSize = GetComponentSize(result.componentType) * result.componentCount;
+        result.stride = view["byteStride"].GetUint(0);
+        if (result.stride == 0)
+            result.stride = elementSize;
+
+        const size_t viewOffset = view["byteOffset"].GetUint();
+        const size_t viewLength = view["byteLength"].GetUint();
+        const size_t offset = accessor["byteOffset"].GetUint();
+        if (viewOffset > std::size(bin) || viewLength > std::size(bin) - viewOffset)
+            throw std::runtime_error("Buffer view outside of the binary chunk");
+        if (result.count > 0 && (offset > viewLength || (result.count - 1) * result.stride + elementSize > viewLength - offset))
+            throw std::runtime_error("Accessor outside of its buffer view");
+
+        result.data = std::data(bin) + viewOffset + offset;
+        return result;
+    }
+
+    float ReadNormalized(const uint8_t* src, uint32_t componentType, uint32_t component)
+    {
+        if (componentType == ComponentUnsignedByte)
+            return src[component] / 255.0f;
+
+        uint16_t value = 0;
+        memcpy(&value, src + component * sizeof(uint16_t), sizeof(uint16_t));
+        return value / 65535.0f;
+    }
+
+    // Copies the first N components of an attribute into a float member of every vertex. Positions and
+    // normals are always float, colors and texture coordinates may also be normalized unsigned integers.
+    template<uint32_t N>
+    void ReadAttribute(const Accessor& accessor, std::vector<Vertex>& vertices, size_t memberOffset)
+    {
+        if (accessor.count != std::size(vertices) || accessor.componentCount < N)
+            throw std::runtime_error("Attribute doesn't match the vertex count or size");
+
+        const bool isFloat = accessor.componentType == ComponentFloat;
+        if (!isFloat && !(accessor.normalized &&
+            (accessor.componentType == ComponentUnsignedByte || accessor.componentType == ComponentUnsignedShort)))
+        {
+            throw UnsupportedError("Attribute component type");
+        }
+
+        for (size_t i = 0; i < std::size(vertices); ++i)
+        {
+            const uint8_t* src = accessor.data + i * accessor.stride;
+            float* dst = (float*)((uint8_t*)&vertices[i] + memberOffset);
+            if (isFloat)
+                memcpy(dst, src, N * sizeof(float));
+            else
+            {
+                for (uint32_t c = 0; c < N; ++c)
+                    dst[c] = ReadNormalized(src, accessor.componentType, c);
+            }
+        }
+    }
+
+    // True when the attributes are interleaved exactly like Vertex, so the buffer view can be used as is
+    bool MatchesVertexLayout(const Accessor& pos, const Accessor* normal, const Accessor* color, const Accessor* texCoord)
+    {
+        const auto matches = [&](const Accessor* accessor, uint32_t componentCount, size_t offset) {
+            return accessor && accessor->componentType == ComponentFloat && accessor->componentCount == componentCount &&
+                accessor->count == pos.count && accessor->stride == sizeof(Vertex) && accessor->data == pos.data + offset;
+        };
+
+        return matches(&pos, 3, offsetof(Vertex, pos)) && matches(normal, 3, offsetof(Vertex, normal)) &&
+            matches(color, 3, offsetof(Vertex, color)) && matches(texCoord, 2, offsetof(Vertex, texCoord)) &&
+            (uintptr_t)pos.data % alignof(Vertex) == 0;
+    }
+
+    PrimitiveData ReadPrimitive(const JsonValue& doc, Span<const uint8_t> bin, const JsonValue& primitive)
+    {
+        if (primitive["mode"].GetUint(PrimitiveTriangles) != PrimitiveTriangles)
+            throw UnsupportedError("Primitives other than triangle lists");
+        if (primitive.HasMember("targets"))
+            throw UnsupportedError("Morph targets");
+
+        const auto& attributes = primitive["attributes"];
+        if (!attributes.HasMember("POSITION"))
+            throw std::runtime_error("Primitive without positions");
+        // Assimp generates normals when they are missing
+        if (!attributes.HasMember("NORMAL"))
+            throw UnsupportedError("Primitives without normals");
+
+        const auto getOptional = [&](const char* name, Accessor& accessor) {
+            if (!attributes.HasMember(name))
+                return (const Accessor*)nullptr;
+            accessor = GetAccessor(doc, bin, attributes[name].GetUint(~0u));
+            return (const Accessor*)&accessor;
+        };
+
+        Accessor pos = GetAccessor(doc, bin, attributes["POSITION"].GetUint(~0u));
+        Accessor normalAccessor, colorAccessor, texCoordAccessor;
+        const Accessor* normal = getOptional("NORMAL", normalAccessor);
+        const Accessor* color = getOptional("COLOR_0", colorAccessor);
+        const Accessor* texCoord = getOptional("TEXCOORD_0", texCoordAccessor);
+
+        PrimitiveData data;
+        if (MatchesVertexLayout(pos, normal, color, texCoord))
+        {
+            data.vertexView = { (const Vertex*)pos.data, pos.count };
+        }
+        else
+        {
+            data.vertices.resize(pos.count);
+            if (pos.componentType != ComponentFloat)
+                throw UnsupportedError("Quantized positions");
+            ReadAttribute<3>(pos, data.vertices, offsetof(Vertex, pos));
+            if (normal->componentType != ComponentFloat)
+                throw UnsupportedError("Quantized normals");
+            ReadAttribute<3>(*normal, data.vertices, offsetof(Vertex, normal));
+            if (color)
+                ReadAttribute<3>(*color, data.vertices, offsetof(Vertex, color));
+            if (texCoord)
+                ReadAttribute<2>(*texCoord, data.vertices, offsetof(Vertex, texCoord));
+            data.vertexView = data.vertices;
+        }
+
+        // POSITION min and max are required by the spec, so the bounds don't need a pass over the vertices
+        const auto& posJson = doc["accessors"][attributes["POSITION"].GetUint()];
+        const auto& min = posJson["min"];
+        const auto& max = posJson["max"];
+        if (min.GetSize() == 3 && max.GetSize() == 3)
+        {
+            data.hasBounds = true;
+            data.bounds = Bounds::FromMinMax(
+                glm::vec3((float)min[0].GetNumber(), (float)min[1].GetNumber(), (float)min[2].GetNumber()),
+                glm::vec3((float)max[0].GetNumber(), (float)max[1].GetNumber(), (float)max[2].GetNumber()));
+        }
+
+        const size_t vertexCount = std::size(data.vertexView);
+        data.indexType = Mesh::ChooseIndexType(vertexCount);
+        if (!primitive.HasMember("indices"))
+        {
+            data.indices.resize(vertexCount - vertexCount % 3);
+            for (size_t i = 0; i < std::size(data.indices); ++i)
+                data.indices[i] = (uint32_t)i;
+            return data;
+        }
+
+        const Accessor indices = GetAccessor(doc, bin, primitive["indices"].GetUint(~0u));
+        if (indices.componentCount != 1 || indices.count % 3 != 0 || (indices.componentType != ComponentUnsignedByte &&
+            indices.componentType != ComponentUnsignedShort && indices.componentType != ComponentUnsignedInt))
+        {
+            throw std::runtime_error("Invalid index accessor");
+        }
+
+        const size_t indexSize = GetComponentSize(indices.componentType);
+        const bool sameType = (indices.componentType == ComponentUnsignedShort && data.indexType == VK_INDEX_TYPE_UINT16) ||
+            (indices.componentType == ComponentUnsignedInt && data.indexType == VK_INDEX_TYPE_UINT32);
+        data.indicesInPlace = sameType && indices.stride == indexSize && (uintptr_t)indices.data % indexSize == 0;
+        if (data.indicesInPlace)
+            data.indexView = { indices.data, indices.count * indexSize };
+        else
+            data.indices.resize(indices.count);
+
+        // Indices are checked even when used in place, the GPU must never read past the vertices
+        for (size_t i = 0; i < indices.count; ++i)
+        {
+            const uint8_t* src = indices.data + i * indices.stride;
+            uint32_t index = 0;
+            if (indexSize == 1)
+                index = *src;
+            else if (indexSize == 2)
+            {
+                uint16_t index16 = 0;
+                memcpy(&index16, src, sizeof(index16));
+                index = index16;
+            }
+            else
+                memcpy(&index, src, sizeof(index));
+
+            if (index >= vertexCount)
+                throw std::runtime_error("Index out of range");
+            if (!data.indicesInPlace)
+                data.indices[i] = index;
+        }
+
+        return data;
+    }
+
+    glm::mat4 GetNodeTransform(const JsonValue& node)
+    {
+        // Matrices are column major like glm
+        const auto& matrix = node["matrix"];
+        if (matrix.GetSize() == 16)
+        {
+            glm::mat4 transform;
+            for (int i = 0; i < 16; ++i)
+                glm::value_ptr(transform)[i] = (float)matrix[i].GetNumber();
+            return transform;
+        }
+
+        const auto& t = node["translation"];
+        const auto& r = node["rotation"];
+        const auto& s = node["scale"];
+
+        glm::mat4 transform(1.0f);
+        if (t.GetSize() == 3)
+            transform = glm::translate(transform, glm::vec3((float)t[0].GetNumber(), (float)t[1].GetNumber(), (float)t[2].GetNumber()));
+        // Stored as x, y, z, w
+        if (r.GetSize() == 4)
+        {
+            const glm::quat rotation((float)r[3].GetNumber(), (float)r[0].GetNumber(), (float)r[1].GetNumber(), (float)r[2].GetNumber());
+            transform *= glm::mat4_cast(rotation);
+        }
+        if (s.GetSize() == 3)
+            transform = glm::scale(transform, glm::vec3((float)s[0].GetNumber(), (float)s[1].GetNumber(), (float)s[2].GetNumber()));
+        return transform;
+    }
+}
+
+std::unique_ptr<Model> GltfLoader::Load(const std::filesystem::path& filepath)
+{
+    auto file = MappedFile::Open(filepath);
+    if (!file)
+    {
+        LOG_ERROR("Failed to open {0}", filepath.string());
+        return {};
+    }
+
+    try
+    {
+        BinaryReader reader(file->GetBytes());
+        const auto header = reader.Read<GlbHeader>();
+        if (header.magic != GlbMagic || header.version != GlbVersion || header.length > file->GetSize())
+            throw std::runtime_error("Not a glTF 2.0 binary");
+
+        const auto jsonChunk = reader.Read<GlbChunkHeader>();
+        if (jsonChunk.type != GlbJsonChunk)
+            throw std::runtime_error("Missing JSON chunk");
+        const auto jsonBytes = reader.ReadArray<uint8_t>(jsonChunk.length);
+
+        // The binary chunk is optional
+        Span<const uint8_t> bin;
+        reader.Align(4);
+        if (reader.GetOffset() + sizeof(GlbChunkHeader) <= header.length)
+        {
+            const auto binChunk = reader.Read<GlbChunkHeader>();
+            if (binChunk.type == GlbBinChunk)
+                bin = reader.ReadArray<uint8_t>(binChunk.length);
+        }
+
+        const JsonValue doc = JsonValue::Parse(std::string_view((const char*)std::data(jsonBytes), std::size(jsonBytes)));
+        if (doc["extensionsRequired"].GetSize() > 0)
+            throw UnsupportedError("Required extensions");
+        if (doc["buffers"].GetSize() > 1 || doc["buffers"][0].HasMember("uri"))
+            throw UnsupportedError("External buffers");
+
+        auto model = std::make_unique<Model>();
+
+        // Materials refer to textures by index so a file used by several materials is only loaded once
+        std::unordered_map<std::string, uint32_t> textureIndices;
+        for (const auto& material : doc["materials"].GetElements())
+        {
+            Material loadedMaterial;
+            loadedMaterial.name = material["name"].GetString();
+
+            const auto& baseColor = material["pbrMetallicRoughness"]["baseColorTexture"];
+            if (baseColor.IsObject())
+            {
+                const auto& texture = doc["textures"][baseColor["index"].GetUint(~0u)];
+                const auto& image = doc["images"][texture["source"].GetUint(~0u)];
+                const auto& uri = image["uri"].GetString();
+                if (!std::empty(uri) && uri.compare(0, 5, "data:") != 0)
+                {
+                    const auto texturePath = "assets/textures/" + std::filesystem::path(uri).filename().string();
+                    const auto [it, inserted] = textureIndices.try_emplace(texturePath, (uint32_t)std::size(model->mTexturePaths));
+                    if (inserted)
+                        model->mTexturePaths.push_back(texturePath);
+                    loadedMaterial.diffuseTexture = it->second;
+                }
+                else
+                    LOG_WARN("Embedded image in material {0} of {1} is not supported", loadedMaterial.name, filepath.string());
+            }
+
+            model->mMaterials.push_back(std::move(loadedMaterial));
+        }
+
+        // Every primitive becomes a Mesh, the primitives of a glTF mesh are consecutive
+        struct PrimitiveRef
+        {
+            const JsonValue* primitive = nullptr;
+            const JsonValue* mesh = nullptr;
+        };
+
+        const auto& meshes = doc["meshes"];
+        std::vector<PrimitiveRef> primitives;
+        std::vector<uint32_t> firstPrimitives;
+        for (const auto& mesh : meshes.GetElements())
+        {
+            firstPrimitives.push_back((uint32_t)std::size(primitives));
+            for (const auto& primitive : mesh["primitives"].GetElements())
+                primitives.push_back({ &primitive, &mesh });
+        }
+        firstPrimitives.push_back((uint32_t)std::size(primitives));
+
+        // Primitives without a material get a default one, like Assimp adds
+        constexpr uint32_t NoMaterial = ~0u;
+        uint32_t defaultMaterial = NoMaterial;
+        for (const auto& ref : primitives)
+        {
+            const uint32_t materialIndex = (*ref.primitive)["material"].GetUint(NoMaterial);
+            if (materialIndex == NoMaterial && defaultMaterial == NoMaterial)
+            {
+                defaultMaterial = (uint32_t)std::size(model->mMaterials);
+                model->mMaterials.push_back({ "DefaultMaterial" });
+            }
+            else if (materialIndex != NoMaterial && materialIndex >= std::size(model->mMaterials))
+                throw std::runtime_error("Invalid material index");
+        }
+
+        model->mMeshs.resize(std::size(primitives));
+        ThreadPool::Get().ParallelFor(std::size(primitives), [&](size_t i) {
+            const auto& primitive = *primitives[i].primitive;
+            auto data = ReadPrimitive(doc, bin, primitive);
+
+            auto mesh = std::make_unique<Mesh>();
+            mesh->mName = (*primitives[i].mesh)["name"].GetString();
+            const uint32_t materialIndex = primitive["material"].GetUint(NoMaterial);
+            mesh->mMaterialIndex = materialIndex == NoMaterial ? defaultMaterial : materialIndex;
+
+            if (std::empty(data.vertices))
+                mesh->mVertexView = data.vertexView;
+            else
+            {
+                mesh->mVertices = std::move(data.vertices);
+                mesh->mVertexView = mesh->mVertices;
+            }
+
+            if (data.indicesInPlace)
+            {
+                mesh->mIndexType = data.indexType;
+                mesh->mIndexCount = uint32_t(data.indexView.size_bytes() / (data.indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4));
+                mesh->mIndexView = data.indexView;
+            }
+            else
+                mesh->SetIndices(data.indices);
+
+            mesh->mBounds = data.hasBounds ? data.bounds : VertexUtils::ComputeBounds(mesh->mVertexView);
+            model->mMeshs[i] = std::move(mesh);
+        });
+
+        // Depth first from the scene's root nodes, a node is always added before its children.
+        // Without a scene every node that isn't a child is a root.
+        const auto& nodes = doc["nodes"];
+        const auto& scene = doc["scenes"][doc["scene"].GetUint(0)];
+        model->mName = scene["name"].GetString();
+
+        std::vector<uint32_t> roots;
+        if (scene.IsObject())
+        {
+            for (const auto& root : scene["nodes"].GetElements())
+                roots.push_back(root.GetUint(~0u));
+        }
+        else
+        {
+            std::vector<bool> isChild(nodes.GetSize());
+            for (const auto& node : nodes.GetElements())
+            {
+                for (const auto& child : node["children"].GetElements())
+                {
+                    if (child.GetUint(~0u) < std::size(isChild))
+                        isChild[child.GetUint()] = true;
+                }
+            }
+            for (uint32_t i = 0; i < std::size(isChild); ++i)
+            {
+                if (!isChild[i])
+                    roots.push_back(i);
+            }
+        }
+
+        std::vector<std::pair<uint32_t, uint32_t>> nodeStack;
+        for (size_t i = std::size(roots); i > 0; --i)
+            nodeStack.emplace_back(roots[i - 1], NodeHierarchy::NoParent);
+
+        std::vector<bool> visited(nodes.GetSize());
+        while (!std::empty(nodeStack))
+        {
+            const auto [gltfNode, parent] = nodeStack.back();
+            nodeStack.pop_back();
+            if (gltfNode >= std::size(visited) || visited[gltfNode])
+                throw std::runtime_error("Invalid node hierarchy");
+            visited[gltfNode] = true;
+
+            const auto& node = nodes[gltfNode];
+            const uint32_t nodeIndex = model->mNodes.AddNode(parent, GetNodeTransform(node));
+            if (node.HasMember("mesh"))
+            {
+                const uint32_t mesh = node["mesh"].GetUint(~0u);
+                if (mesh >= meshes.GetSize())
+                    throw std::runtime_error("Invalid mesh index");
+                for (uint32_t i = firstPrimitives[mesh]; i < firstPrimitives[mesh + 1]; ++i)
+                    model->mInstances.push_back({ i, nodeIndex });
+            }
+
+            const auto& children = node["children"].GetElements();
+            for (size_t i = std::size(children); i > 0; --i)
+                nodeStack.emplace_back(children[i - 1].GetUint(~0u), nodeIndex);
+        }
+
+        model->mMappedFile = std::move(file);
+
+        LOG_INFO("Loaded {0} with {1} meshes and {2} instances", filepath.string(), std::size(model->mMeshs), std::size(model->mInstances));
+        return model;
+    }
+    catch (const UnsupportedError& e)
+    {
+        LOG_INFO("{0} uses an unsupported glTF feature ({1}), loading it through Assimp", filepath.string(), e.what());
+        return {};
+    }
+    catch (const std::exception& e)
+    {
+        LOG_WARN("Failed to load {0}: {1}", filepath.string(), e.what());
+        return {};
+    }
+}
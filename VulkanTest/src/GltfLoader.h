@@ -0,0 +1,15 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+class Model;
+
+// Direct loader for binary glTF (.glb). The file is memory mapped and meshes are built straight from
+// its buffer views, vertex and index data that already has the renderer's layout is used in place.
+// Returns null for anything it doesn't handle, the caller then falls back to Assimp.
+class GltfLoader
+{
+public:
+    static std::unique_ptr<Model> Load(const std::filesystem::path& filepath);
+};
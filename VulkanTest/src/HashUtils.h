@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace HashUtils
+{
+    uint64_t Hash64(const void* data, size_t size, uint64_t seed = 0);
+}
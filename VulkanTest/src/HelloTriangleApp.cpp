@@ -8,11 +8,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include <stb_image.h>
-
 #include <chrono>
 
 #include <stdexcept>
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -24,7 +23,10 @@
 #include "SwapChainSupportDetails.h"
 #include "FileUtils.h"
 #include "UniformBufferObject.h"
+#include "DrawPushConstants.h"
 #include "Properties.h"
+#include "ThreadPool.h"
+#include "Frustum.h"
 
 HelloTriangleApp::~HelloTriangleApp()
 {
@@ -33,12 +35,16 @@ HelloTriangleApp::~HelloTriangleApp()
 
 void HelloTriangleApp::InitWindow()
 {
+    mStartTime = std::chrono::steady_clock::now();
+
     if (!glfwInit())
     {
         throw std::runtime_error("Failed to init GLFW");
     }
 
     Properties props = Properties::ReadFile("assets/App.properties");
+    // Set before anything uses the pool, the texture load log reports the count so load times can be compared
+    ThreadPool::SetSharedThreadCount(props.GetUInt32("threadPoolSize").value_or(0));
     const auto width = props.GetUInt32("windowWidth").value_or(WindowWidth);
     const auto height = props.GetUInt32("windowHeight").value_or(WindowHeight);
     const auto title = props.GetString("windowTitle").value_or("Vulkan Test");
@@ -51,7 +57,57 @@ void HelloTriangleApp::InitWindow()
     glfwSetWindowUserPointer(mWindow, this);
     glfwSetFramebufferSizeCallback(mWindow, FramebufferResizeCallback);
 
-    mModel = Model::Load(props.GetString("modelFile").value_or("assets/meshes/VikingRoom.fbx"));
+    ModelLoadOptions loadOptions;
+    loadOptions.useCache = props.GetUInt32("useMeshCache").value_or(1) != 0;
+    loadOptions.compressCache = props.GetUInt32("compressMeshCache").value_or(0) != 0;
+    loadOptions.decodeBenchRuns = props.GetUInt32("meshDecodeBenchRuns").value_or(0);
+    loadOptions.weldVertices = props.GetUInt32("weldVertices").value_or(0) != 0;
+    loadOptions.weldEpsilon = props.GetFloat("weldEpsilon").value_or(loadOptions.weldEpsilon);
+    loadOptions.optimizeVertexCache = props.GetUInt32("optimizeVertexCache").value_or(0) != 0;
+    loadOptions.optimizeOverdraw = props.GetUInt32("optimizeOverdraw").value_or(0) != 0;
+    loadOptions.overdrawThreshold = props.GetFloat("overdrawThreshold").value_or(loadOptions.overdrawThreshold);
+    loadOptions.optimizeVertexFetch = props.GetUInt32("optimizeVertexFetch").value_or(0) != 0;
+    loadOptions.buildMeshlets = props.GetUInt32("buildMeshlets").value_or(0) != 0;
+    loadOptions.lodCount = props.GetUInt32("lodCount").value_or(loadOptions.lodCount);
+    loadOptions.lodRatio = props.GetFloat("lodRatio").value_or(loadOptions.lodRatio);
+    mLodPixelError = props.GetFloat("lodPixelError").value_or(mLodPixelError);
+    mTextureLoadOptions.useCache = props.GetUInt32("useTextureCache").value_or(1) != 0;
+    mTextureLoadOptions.generateMips = props.GetUInt32("cpuTextureMips").value_or(0) != 0;
+    mTextureLoadBench = props.GetUInt32("textureLoadBench").value_or(0) != 0;
+    mStreamTextures = props.GetUInt32("streamTextures").value_or(0) != 0;
+    mTextureTailSize = props.GetUInt32("textureTailSize").value_or(mTextureTailSize);
+    mTextureGpuMemory = VkDeviceSize(props.GetUInt32("textureGpuMemoryMB").value_or(256)) << 20;
+    if (mStreamTextures && !mTextureLoadOptions.useCache)
+    {
+        LOG_WARN("streamTextures needs useTextureCache, textures are loaded whole");
+        mStreamTextures = false;
+    }
+    const auto textureCompression = props.GetString("textureCompression").value_or("none");
+    if (textureCompression == "bc1")
+        mTextureLoadOptions.compression = TextureCompression::BC1;
+    else if (textureCompression == "bc5")
+        mTextureLoadOptions.compression = TextureCompression::BC5;
+    else if (textureCompression == "bc7")
+        mTextureLoadOptions.compression = TextureCompression::BC7;
+
+    // Streaming reads the model through a page cache so it doesn't have to fit in memory
+    const std::filesystem::path modelFile = props.GetString("modelFile").value_or("assets/meshes/VikingRoom.fbx");
+    mStreamModel = props.GetUInt32("streamModel").value_or(0) != 0;
+    mPageCacheMemory = size_t(props.GetUInt32("pageCacheMemoryMB").value_or(512)) << 20;
+    mPageGpuMemory = size_t(props.GetUInt32("pageGpuMemoryMB").value_or(256)) << 20;
+    if (mStreamModel)
+    {
+        mPagedModelFuture = ThreadPool::Get().Submit([modelFile, loadOptions]() {
+            return PagedModel::Load(modelFile, loadOptions);
+        });
+    }
+    else
+        mModelFuture = Model::LoadAsync(modelFile, loadOptions);
+
+    if (props.GetString("vertexFormat").value_or("float") == "packed")
+        mVertexLayout.format = VertexFormat::Packed;
+    if (props.GetString("vertexStreams").value_or("interleaved") == "split")
+        mVertexLayout.streams = VertexStreams::SplitPosition;
 }
 
 void HelloTriangleApp::InitVulkan()
@@ -70,11 +126,6 @@ void HelloTriangleApp::InitVulkan()
     CreateColorResources();
     CreateDepthResources();
     CreateFramebuffers();
-    CreateTextureImage();
-    CreateTextureImageView();
-    CreateTextureSampler();
-    CreateVertexBuffer();
-    CreateIndexBuffer();
     CreateUniformBuffers();
     CreateDescriptorPool();
     CreateDescriptorSets();
@@ -97,9 +148,49 @@ void HelloTriangleApp::Cleanup()
 {
     CleanupSwapChain();
 
+    // Textures still loading when the window closed have to finish before their staging buffers can be freed
+    for (auto& future : mTextureFutures)
+    {
+        if (future.valid())
+        {
+            const auto texture = future.get();
+            vkDestroyBuffer(mDevice, texture.stagingBuffer, nullptr);
+            vkFreeMemory(mDevice, texture.stagingBufferMem, nullptr);
+        }
+    }
+    mTextureFutures.clear();
+
+    for (const auto& [buffer, bufferMem] : mUploadStagingBuffers)
+    {
+        vkDestroyBuffer(mDevice, buffer, nullptr);
+        vkFreeMemory(mDevice, bufferMem, nullptr);
+    }
+    mUploadStagingBuffers.clear();
+
+    vkDestroyFence(mDevice, mUploadFence, nullptr);
+    mUploadFence = VK_NULL_HANDLE;
+
+    // Level reads still running read from the texture sources, the staging buffers they filled were never used
+    for (auto& texture : mStreamedTextures)
+    {
+        if (texture.pendingRead.valid())
+        {
+            const StagedLevels staged = texture.pendingRead.get();
+            vkDestroyBuffer(mDevice, staged.stagingBuffer, nullptr);
+            vkFreeMemory(mDevice, staged.stagingBufferMem, nullptr);
+        }
+    }
+    ReleaseRetiredTextures(true);
+    mStreamedTextures.clear();
+
+    vkDestroyDescriptorPool(mDevice, mTextureDescriptorPool, nullptr);
+    mTextureDescriptorPool = VK_NULL_HANDLE;
+    mTextureDescriptorSets.clear();
+
     vkDestroySampler(mDevice, mTexSampler, nullptr);
     mTexSampler = VK_NULL_HANDLE;
-    mTexImage.Destroy();
+    for (auto& image : mTextureImages)
+        image.Destroy();
 
     for (int i = 0; i < std::size(mUniformBuffers); ++i)
     {
@@ -115,6 +206,8 @@ void HelloTriangleApp::Cleanup()
 
     vkDestroyDescriptorSetLayout(mDevice, mDescriptorSetLayout, nullptr);
     mDescriptorSetLayout = VK_NULL_HANDLE;
+    vkDestroyDescriptorSetLayout(mDevice, mTextureSetLayout, nullptr);
+    mTextureSetLayout = VK_NULL_HANDLE;
 
     vkDestroyBuffer(mDevice, mIndexBuffer, nullptr);
     mIndexBuffer = VK_NULL_HANDLE;
@@ -126,8 +219,14 @@ void HelloTriangleApp::Cleanup()
     vkFreeMemory(mDevice, mVertexBufferMem, nullptr);
     mVertexBufferMem = VK_NULL_HANDLE;
 
-    vkDestroyBuffer(mDevice, mVertexBuffer, nullptr);
-    mVertexBuffer = VK_NULL_HANDLE;
+    for (int i = 0; i < std::size(mPageStagingBuffers); ++i)
+    {
+        vkDestroyBuffer(mDevice, mPageStagingBuffers[i], nullptr);
+        vkFreeMemory(mDevice, mPageStagingBuffersMem[i], nullptr);
+    }
+    mPageStagingBuffers.clear();
+    mPageStagingBuffersMem.clear();
+    mPageStagingBuffersMapped.clear();
 
     vkDestroyPipeline(mDevice, mGraphicsPipeline, nullptr);
     mGraphicsPipeline = VK_NULL_HANDLE;
@@ -243,6 +342,15 @@ void HelloTriangleApp::PickPhysicalDevice()
 
     if (mPhysicalDevice == VK_NULL_HANDLE)
         throw std::runtime_error("Failed to find a suitable GPU");
+
+    // Without linear blits the mip chain is built on the CPU while the texture loads
+    VkFormatProperties formatProps{};
+    vkGetPhysicalDeviceFormatProperties(mPhysicalDevice, VK_FORMAT_R8G8B8A8_SRGB, &formatProps);
+    if (!(formatProps.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) && !mTextureLoadOptions.generateMips)
+    {
+        LOG_INFO("Device can't blit textures with linear filtering, generating mips on the CPU");
+        mTextureLoadOptions.generateMips = true;
+    }
 }
 
 void HelloTriangleApp::CreateLogicalDevice()
@@ -263,8 +371,17 @@ void HelloTriangleApp::CreateLogicalDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    VkPhysicalDeviceFeatures supportedFeatures{};
+    vkGetPhysicalDeviceFeatures(mPhysicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+    if (!supportedFeatures.textureCompressionBC && mTextureLoadOptions.compression != TextureCompression::None)
+    {
+        LOG_WARN("Device does not support BC textures, uploading them uncompressed");
+        mTextureLoadOptions.compression = TextureCompression::None;
+    }
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -413,24 +530,31 @@ void HelloTriangleApp::CreateRenderPass()
 
 void HelloTriangleApp::CreateDescriptorSetLayout()
 {
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings{};
-    bindings[0].binding = 0;
-    bindings[0].descriptorCount = 1;
-    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-    bindings[1].binding = 1;
-    bindings[1].descriptorCount = 1;
-    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutBinding uboBinding{};
+    uboBinding.binding = 0;
+    uboBinding.descriptorCount = 1;
+    uboBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    uboBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
     VkDescriptorSetLayoutCreateInfo layoutInfo{};
     layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.pBindings = std::data(bindings);
-    layoutInfo.bindingCount = (uint32_t)std::size(bindings);
+    layoutInfo.pBindings = &uboBinding;
+    layoutInfo.bindingCount = 1;
 
     if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mDescriptorSetLayout) != VK_SUCCESS)
         throw std::runtime_error("Failed to create descriptor set layout");
+
+    // Textures get their own set so draws only rebind it when the material's texture changes
+    VkDescriptorSetLayoutBinding samplerBinding{};
+    samplerBinding.binding = 0;
+    samplerBinding.descriptorCount = 1;
+    samplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    samplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    layoutInfo.pBindings = &samplerBinding;
+
+    if (vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mTextureSetLayout) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create texture descriptor set layout");
 }
 
 void HelloTriangleApp::CreateGraphicsPipeline()
@@ -444,13 +568,27 @@ void HelloTriangleApp::CreateGraphicsPipeline()
     shaderStageInfos[0].module = vertShaderModule;
     shaderStageInfos[0].pName = "main";
 
+    // Constant 0 tells the vertex shader the normals are octahedral encoded
+    const VkBool32 octahedralNormals = mVertexLayout.format == VertexFormat::Packed ? VK_TRUE : VK_FALSE;
+    VkSpecializationMapEntry specEntry{};
+    specEntry.constantID = 0;
+    specEntry.offset = 0;
+    specEntry.size = sizeof(VkBool32);
+
+    VkSpecializationInfo vertSpecInfo{};
+    vertSpecInfo.mapEntryCount = 1;
+    vertSpecInfo.pMapEntries = &specEntry;
+    vertSpecInfo.dataSize = sizeof(VkBool32);
+    vertSpecInfo.pData = &octahedralNormals;
+    shaderStageInfos[0].pSpecializationInfo = &vertSpecInfo;
+
     shaderStageInfos[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     shaderStageInfos[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
     shaderStageInfos[1].module = fragShaderModule;
     shaderStageInfos[1].pName = "main";
 
-    const auto bindingDescs = Vertex::GetBindingDescriptions();
-    const auto attrDescs = Vertex::GetAttributeDescriptions();
+    const auto bindingDescs = mVertexLayout.GetBindingDescriptions();
+    const auto attrDescs = mVertexLayout.GetAttributeDescriptions();
 
     VkPipelineVertexInputStateCreateInfo vertInputInfo{};
     vertInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -522,8 +660,16 @@ void HelloTriangleApp::CreateGraphicsPipeline()
 
     VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
     pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.pSetLayouts = &mDescriptorSetLayout;
-    pipelineLayoutInfo.setLayoutCount = 1;
+    const std::array<VkDescriptorSetLayout, 2> setLayouts = { mDescriptorSetLayout, mTextureSetLayout };
+    pipelineLayoutInfo.pSetLayouts = std::data(setLayouts);
+    pipelineLayoutInfo.setLayoutCount = (uint32_t)std::size(setLayouts);
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(DrawPushConstants);
+    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
 
     if (vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &mPipelineLayout) != VK_SUCCESS)
         throw std::runtime_error("Failed to create pipeline layout");
@@ -617,52 +763,79 @@ void HelloTriangleApp::CreateDepthResources()
     mDepthImage.mImageView = CreateImageView(mDepthImage.mImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 }
 
-void HelloTriangleApp::CreateTextureImage()
+void HelloTriangleApp::CreateTextureImages()
 {
-    constexpr VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-    mTexImage.mDevice = mDevice;
-
-    int texWidth = 0;
-    int texHeight = 0;
-    int texChannels = 0;
-    const auto deleter = [&](stbi_uc* ptr) { stbi_image_free(ptr); };
-    std::unique_ptr<stbi_uc, decltype(deleter)> pixels(stbi_load(std::data(mModel->GetDiffuseTextureName()),
-        &texWidth, &texHeight, &texChannels, STBI_rgb_alpha), deleter);
-
-    if (!pixels)
-        throw std::runtime_error("Failed to load texture image");
-
-    const VkDeviceSize imageSize = VkDeviceSize(texWidth * texHeight * 4);
+    // The model's textures were recorded as their jobs finished, the extra image at the end is plain white
+    // for materials without a texture or whose texture failed to load
+    constexpr uint8_t white[4] = { 255, 255, 255, 255 };
+    StagedTexture fallback;
+    fallback.image = Image::Create(1, 1, white);
+    StageTexture(fallback);
+    CreateTextureImage(fallback, mTextureImages.back(), mTextureMipLevels.back());
+    mTextureFormats.back() = fallback.image->GetFormat();
+}
 
-    mMipLevels = (uint32_t)std::floor(std::log2(std::max(texWidth, texHeight))) + 1;
+void HelloTriangleApp::StageTexture(StagedTexture& texture)
+{
+    constexpr VkMemoryPropertyFlags props = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-    VkBuffer stagingBuffer{};
-    VkDeviceMemory stagingBufferMem{};
-    CreateBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, props, stagingBuffer, stagingBufferMem);
+    // The levels are back to back, so everything from the first level on is one range
+    const auto pixels = texture.image->GetPixels();
+    const VkDeviceSize offset = texture.image->GetMips()[texture.firstLevel].offset;
+    const VkDeviceSize size = std::size(pixels) - offset;
+    CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, props, texture.stagingBuffer, texture.stagingBufferMem);
 
     void* data = nullptr;
-    vkMapMemory(mDevice, stagingBufferMem, 0, imageSize, 0, &data);
-    memcpy(data, pixels.get(), (size_t)imageSize);
-    vkUnmapMemory(mDevice, stagingBufferMem);
-
-    pixels = nullptr;
-
-    constexpr VkImageUsageFlags imageUsage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-    CreateImage(texWidth, texHeight, mMipLevels, VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
-        imageUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mTexImage.mImage, mTexImage.mImageMem);
-
-    TransitionImageLayout(mTexImage.mImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mMipLevels);
-    CopyBufferToImage(stagingBuffer, mTexImage.mImage, (uint32_t)texWidth, (uint32_t)texHeight);
+    vkMapMemory(mDevice, texture.stagingBufferMem, 0, size, 0, &data);
+    memcpy(data, std::data(pixels) + offset, (size_t)size);
+    vkUnmapMemory(mDevice, texture.stagingBufferMem);
+}
 
-    GenerateMipmaps(mTexImage.mImage, VK_FORMAT_R8G8B8A8_SRGB, texWidth, texHeight, mMipLevels);
+void HelloTriangleApp::CreateTextureImage(const StagedTexture& texture, VulkanImage& image, uint32_t& mipLevels)
+{
+    image.mDevice = mDevice;
+
+    // Levels above the first one aren't staged, the image starts at the first level
+    const auto& allMips = texture.image->GetMips();
+    const ImageMip& firstMip = allMips[texture.firstLevel];
+    std::vector<ImageMip> mips(std::begin(allMips) + texture.firstLevel, std::end(allMips));
+    for (auto& mip : mips)
+        mip.offset -= firstMip.offset;
+
+    const uint32_t texWidth = firstMip.width;
+    const uint32_t texHeight = firstMip.height;
+    const VkFormat format = texture.image->GetFormat();
+
+    // Cooked, compressed and CPU mipped textures come with every level, otherwise the chain is blitted from the full size level
+    mipLevels = Image::GetMipCount(texWidth, texHeight);
+    const bool hasMips = std::size(mips) == mipLevels;
+
+    // Streamed textures copy their resident levels out when they are resized
+    VkImageUsageFlags imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (!hasMips || texture.stream)
+        imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    CreateImage(texWidth, texHeight, mipLevels, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
+        imageUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image.mImage, image.mImageMem);
+
+    TransitionImageLayout(image.mImage, format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels);
+    CopyBufferToImage(texture.stagingBuffer, image.mImage, mips);
+
+    if (hasMips)
+        TransitionImageLayout(image.mImage, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, mipLevels);
+    else
+        GenerateMipmaps(image.mImage, format, texWidth, texHeight, mipLevels);
 
-    vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
-    vkFreeMemory(mDevice, stagingBufferMem, nullptr);
+    DestroyStagingBuffer(texture.stagingBuffer, texture.stagingBufferMem);
 }
 
-void HelloTriangleApp::CreateTextureImageView()
+void HelloTriangleApp::CreateTextureImageViews()
 {
-    mTexImage.mImageView = CreateImageView(mTexImage.mImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, mMipLevels);
+    for (size_t i = 0; i < std::size(mTextureImages); ++i)
+    {
+        auto& image = mTextureImages[i];
+        if (image.mImage != VK_NULL_HANDLE)
+            image.mImageView = CreateImageView(image.mImage, mTextureFormats[i], VK_IMAGE_ASPECT_COLOR_BIT, mTextureMipLevels[i]);
+    }
 }
 
 void HelloTriangleApp::CreateTextureSampler()
@@ -685,7 +858,8 @@ void HelloTriangleApp::CreateTextureSampler()
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
     samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = (float)mMipLevels;
+    // Streamed textures gain levels after the sampler is created, the image views limit the levels instead
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
     samplerInfo.mipLodBias = 0.0f;
 
     if (vkCreateSampler(mDevice, &samplerInfo, nullptr, &mTexSampler) != VK_SUCCESS)
@@ -694,7 +868,35 @@ void HelloTriangleApp::CreateTextureSampler()
 
 void HelloTriangleApp::CreateVertexBuffer()
 {
-    const VkDeviceSize bufferSize = VkDeviceSize(sizeof(Vertex) * std::size(mModel->GetMeshes()[0]->GetVertices()));
+    const bool packed = mVertexLayout.format == VertexFormat::Packed;
+    const bool split = mVertexLayout.streams == VertexStreams::SplitPosition;
+    const size_t vertexSize = mVertexLayout.GetVertexSize();
+    const size_t positionSize = mVertexLayout.GetPositionSize();
+
+    size_t vertexCount = 0;
+    mMeshDraws.clear();
+    mMeshDraws.reserve(std::size(mModel->GetMeshes()));
+    for (const auto& mesh : mModel->GetMeshes())
+    {
+        MeshDrawInfo draw;
+        draw.mesh = mesh.get();
+        draw.vertexOffset = (int32_t)vertexCount;
+        draw.materialIndex = mesh->GetMaterialIndex();
+
+        if (packed)
+            draw.quantization = PackedVertex::ComputePositionQuantization(mesh->GetBounds());
+
+        vertexCount += std::size(mesh->GetVertices());
+        mMeshDraws.push_back(draw);
+    }
+
+    // Split streams store every position first followed by the rest of the attributes
+    mVertexAttributeOffset = split ? VkDeviceSize(positionSize * vertexCount) : 0;
+    mVertexAttributeOffset = (mVertexAttributeOffset + 15) & ~VkDeviceSize(15);
+
+    const VkDeviceSize bufferSize = split ?
+        mVertexAttributeOffset + VkDeviceSize((vertexSize - positionSize) * vertexCount) :
+        VkDeviceSize(vertexSize * vertexCount);
     constexpr VkMemoryPropertyFlags stagingProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
     VkBuffer stagingBuffer{};
@@ -703,7 +905,15 @@ void HelloTriangleApp::CreateVertexBuffer()
 
     void* data = nullptr;
     vkMapMemory(mDevice, stagingBufferMem, 0, bufferSize, 0, &data);
-    memcpy(data, std::data(mModel->GetMeshes()[0]->GetVertices()), (size_t)bufferSize);
+    uint8_t* dst = (uint8_t*)data;
+    uint8_t* attrDst = (uint8_t*)data + mVertexAttributeOffset;
+    for (size_t i = 0; i < std::size(mMeshDraws); ++i)
+    {
+        const auto vertices = mModel->GetMeshes()[i]->GetVertices();
+        mVertexLayout.WriteVertices(vertices, mMeshDraws[i].quantization, dst, attrDst);
+        dst += std::size(vertices) * (split ? positionSize : vertexSize);
+        attrDst += split ? std::size(vertices) * (vertexSize - positionSize) : 0;
+    }
     vkUnmapMemory(mDevice, stagingBufferMem);
 
     constexpr VkBufferUsageFlags vertUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
@@ -711,13 +921,39 @@ void HelloTriangleApp::CreateVertexBuffer()
 
     CopyBuffer(stagingBuffer, mVertexBuffer, bufferSize);
 
-    vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
-    vkFreeMemory(mDevice, stagingBufferMem, nullptr);
+    DestroyStagingBuffer(stagingBuffer, stagingBufferMem);
 }
 
 void HelloTriangleApp::CreateIndexBuffer()
 {
-    const VkDeviceSize bufferSize = VkDeviceSize(sizeof(uint16_t) * std::size(mModel->GetMeshes()[0]->GetIndices()));
+    // 16-bit indices are packed at the start of the buffer and 32-bit indices after them,
+    // so the index buffer only has to be bound once per index width.
+    VkDeviceSize indexDataSize16 = 0;
+    VkDeviceSize indexDataSize32 = 0;
+
+    // The draws were created along with the vertex buffer, one per mesh
+    for (size_t i = 0; i < std::size(mMeshDraws); ++i)
+    {
+        const auto& mesh = mModel->GetMeshes()[i];
+        auto& draw = mMeshDraws[i];
+        draw.indexCount = mesh->GetIndexCount();
+        draw.indexType = mesh->GetIndexType();
+
+        if (draw.indexType == VK_INDEX_TYPE_UINT16)
+        {
+            draw.firstIndex = uint32_t(indexDataSize16 / sizeof(uint16_t));
+            indexDataSize16 += mesh->GetIndexData().size_bytes();
+        }
+        else
+        {
+            draw.firstIndex = uint32_t(indexDataSize32 / sizeof(uint32_t));
+            indexDataSize32 += mesh->GetIndexData().size_bytes();
+        }
+    }
+
+    mIndexBuffer32Offset = (indexDataSize16 + sizeof(uint32_t) - 1) & ~VkDeviceSize(sizeof(uint32_t) - 1);
+
+    const VkDeviceSize bufferSize = mIndexBuffer32Offset + indexDataSize32;
     constexpr VkMemoryPropertyFlags stagingProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
     VkBuffer stagingBuffer{};
@@ -726,7 +962,15 @@ void HelloTriangleApp::CreateIndexBuffer()
 
     void* data = nullptr;
     vkMapMemory(mDevice, stagingBufferMem, 0, bufferSize, 0, &data);
-    memcpy(data, std::data(mModel->GetMeshes()[0]->GetIndices()), (size_t)bufferSize);
+    for (size_t i = 0; i < std::size(mMeshDraws); ++i)
+    {
+        const auto& draw = mMeshDraws[i];
+        const auto indexData = mModel->GetMeshes()[i]->GetIndexData();
+        const VkDeviceSize dstOffset = draw.indexType == VK_INDEX_TYPE_UINT16 ?
+            VkDeviceSize(draw.firstIndex) * sizeof(uint16_t) :
+            mIndexBuffer32Offset + VkDeviceSize(draw.firstIndex) * sizeof(uint32_t);
+        memcpy((uint8_t*)data + dstOffset, std::data(indexData), indexData.size_bytes());
+    }
     vkUnmapMemory(mDevice, stagingBufferMem);
 
     constexpr VkBufferUsageFlags indexUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
@@ -734,8 +978,74 @@ void HelloTriangleApp::CreateIndexBuffer()
 
     CopyBuffer(stagingBuffer, mIndexBuffer, bufferSize);
 
-    vkDestroyBuffer(mDevice, stagingBuffer, nullptr);
-    vkFreeMemory(mDevice, stagingBufferMem, nullptr);
+    DestroyStagingBuffer(stagingBuffer, stagingBufferMem);
+
+    // One draw per instance, instances of the same mesh share its vertices and indices
+    std::vector<MeshDrawInfo> meshDraws;
+    meshDraws.swap(mMeshDraws);
+    mMeshDraws.reserve(std::size(mModel->GetInstances()));
+    const auto& worldTransforms = mModel->GetNodes().GetWorldTransforms();
+    for (const auto& instance : mModel->GetInstances())
+    {
+        MeshDrawInfo draw = meshDraws[instance.meshIndex];
+        draw.transform = worldTransforms[instance.nodeIndex];
+        draw.bounds = draw.mesh->GetBounds().Transform(draw.transform);
+        mMeshDraws.push_back(draw);
+    }
+
+    // Group the draws by index width and then by texture to keep rebinding down
+    std::stable_sort(std::begin(mMeshDraws), std::end(mMeshDraws), [this](const MeshDrawInfo& a, const MeshDrawInfo& b) {
+        if (a.indexType != b.indexType)
+            return a.indexType == VK_INDEX_TYPE_UINT16;
+        return GetMaterialTexture(a.materialIndex) < GetMaterialTexture(b.materialIndex);
+    });
+}
+
+void HelloTriangleApp::CreatePageBuffers()
+{
+    const bool split = mVertexLayout.streams == VertexStreams::SplitPosition;
+    const size_t vertexSize = mVertexLayout.GetVertexSize();
+    const size_t positionSize = mVertexLayout.GetPositionSize();
+    const VkDeviceSize slotVertexSize = VkDeviceSize(GeometryPage::MaxVertices * vertexSize);
+    const VkDeviceSize slotIndexSize = VkDeviceSize(GeometryPage::MaxIndices * sizeof(uint16_t));
+
+    // Every slot fits the largest page, so the GPU memory cap is a plain slot count
+    const uint32_t slotCount = std::max(uint32_t(mPageGpuMemory / (slotVertexSize + slotIndexSize)), 1u);
+    mPageSlots.assign(slotCount, {});
+    mPageSlotIndices.assign(std::size(mPagedModel->GetPages()), NoPageSlot);
+    mPageCache = std::make_unique<PageCache>(*mPagedModel, mPageCacheMemory);
+
+    // Same stream layout as CreateVertexBuffer with slot i starting at vertex i * MaxVertices
+    const VkDeviceSize vertexCapacity = VkDeviceSize(slotCount) * GeometryPage::MaxVertices;
+    mVertexAttributeOffset = split ? VkDeviceSize(positionSize) * vertexCapacity : 0;
+    mVertexAttributeOffset = (mVertexAttributeOffset + 15) & ~VkDeviceSize(15);
+
+    const VkDeviceSize vertexBufferSize = split ?
+        mVertexAttributeOffset + VkDeviceSize(vertexSize - positionSize) * vertexCapacity :
+        VkDeviceSize(vertexSize) * vertexCapacity;
+    const VkDeviceSize indexBufferSize = slotIndexSize * slotCount;
+
+    constexpr VkBufferUsageFlags vertUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    CreateBuffer(vertexBufferSize, vertUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mVertexBuffer, mVertexBufferMem);
+
+    constexpr VkBufferUsageFlags indexUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    CreateBuffer(indexBufferSize, indexUsage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, mIndexBuffer, mIndexBufferMem);
+    mIndexBuffer32Offset = indexBufferSize;
+
+    // Each frame stages its page uploads in its own buffer, which is free again once the frame's fence signals
+    constexpr VkMemoryPropertyFlags stagingProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    const VkDeviceSize stagingSize = (slotVertexSize + slotIndexSize) * MaxPageUploadsPerFrame;
+
+    mPageStagingBuffers.resize(MaxFramesInFlight);
+    mPageStagingBuffersMem.resize(MaxFramesInFlight);
+    mPageStagingBuffersMapped.resize(MaxFramesInFlight);
+    for (int i = 0; i < MaxFramesInFlight; ++i)
+    {
+        CreateBuffer(stagingSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingProps, mPageStagingBuffers[i], mPageStagingBuffersMem[i]);
+        vkMapMemory(mDevice, mPageStagingBuffersMem[i], 0, stagingSize, 0, &mPageStagingBuffersMapped[i]);
+    }
+
+    LOG_INFO("Streaming {0} pages through {1} GPU page slots", std::size(mPagedModel->GetPages()), slotCount);
 }
 
 void HelloTriangleApp::CreateUniformBuffers()
@@ -756,16 +1066,14 @@ void HelloTriangleApp::CreateUniformBuffers()
 
 void HelloTriangleApp::CreateDescriptorPool()
 {
-    std::array<VkDescriptorPoolSize, 2> poolSizes{};
-    poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    poolSizes[0].descriptorCount = MaxFramesInFlight;
-    poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSizes[1].descriptorCount = MaxFramesInFlight;
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    poolSize.descriptorCount = MaxFramesInFlight;
 
     VkDescriptorPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.pPoolSizes = std::data(poolSizes);
-    poolInfo.poolSizeCount = (uint32_t)std::size(poolSizes);
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.poolSizeCount = 1;
     poolInfo.maxSets = MaxFramesInFlight;
 
     if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mDescriptorPool) != VK_SUCCESS)
@@ -792,30 +1100,78 @@ void HelloTriangleApp::CreateDescriptorSets()
         bufferInfo.offset = 0;
         bufferInfo.range = sizeof(UniformBufferObject);
 
-        VkDescriptorImageInfo imageInfo{};
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = mTexImage.mImageView;
-        imageInfo.sampler = mTexSampler;
+        VkWriteDescriptorSet descWrite{};
+        descWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descWrite.dstSet = mDescriptorSets[i];
+        descWrite.dstBinding = 0;
+        descWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descWrite.descriptorCount = 1;
+        descWrite.pBufferInfo = &bufferInfo;
+
+        vkUpdateDescriptorSets(mDevice, 1, &descWrite, 0, nullptr);
+    }
+}
 
-        std::array<VkWriteDescriptorSet, 2> descWrites{};
-        descWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descWrites[0].dstSet = mDescriptorSets[i];
-        descWrites[0].dstBinding = 0;
-        descWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-        descWrites[0].descriptorCount = 1;
-        descWrites[0].pBufferInfo = &bufferInfo;
+void HelloTriangleApp::CreateTextureDescriptorSets()
+{
+    const uint32_t setCount = (uint32_t)std::size(mTextureImages);
+
+    // A resized streamed texture gets a new set while its old one can still be used by a frame in flight.
+    // Textures are only resized again once the old set is freed, so one spare set per texture is enough
+    const uint32_t maxSets = mStreamTextures ? setCount * 2 : setCount;
+
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = maxSets;
+
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = mStreamTextures ? VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT : 0;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.maxSets = maxSets;
+
+    if (vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mTextureDescriptorPool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create texture descriptor pool");
+
+    std::vector<VkDescriptorSetLayout> layouts(setCount, mTextureSetLayout);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = mTextureDescriptorPool;
+    allocInfo.descriptorSetCount = setCount;
+    allocInfo.pSetLayouts = std::data(layouts);
 
-        descWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descWrites[1].dstSet = mDescriptorSets[i];
-        descWrites[1].dstBinding = 1;
-        descWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descWrites[1].descriptorCount = 1;
-        descWrites[1].pImageInfo = &imageInfo;
+    mTextureDescriptorSets.resize(setCount);
+    if (vkAllocateDescriptorSets(mDevice, &allocInfo, std::data(mTextureDescriptorSets)) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate texture descriptor sets");
 
-        vkUpdateDescriptorSets(mDevice, (uint32_t)std::size(descWrites), std::data(descWrites), 0, nullptr);
+    // Textures that failed to load are pointed at the fallback image
+    const VulkanImage& fallback = mTextureImages.back();
+    for (uint32_t i = 0; i < setCount; ++i)
+    {
+        const VulkanImage& image = mTextureImages[i].mImageView != VK_NULL_HANDLE ? mTextureImages[i] : fallback;
+        WriteTextureDescriptorSet(mTextureDescriptorSets[i], image.mImageView);
     }
 }
 
+void HelloTriangleApp::WriteTextureDescriptorSet(VkDescriptorSet descriptorSet, VkImageView imageView)
+{
+    VkDescriptorImageInfo imageInfo{};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = imageView;
+    imageInfo.sampler = mTexSampler;
+
+    VkWriteDescriptorSet descWrite{};
+    descWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descWrite.dstSet = descriptorSet;
+    descWrite.dstBinding = 0;
+    descWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descWrite.descriptorCount = 1;
+    descWrite.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(mDevice, 1, &descWrite, 0, nullptr);
+}
+
 void HelloTriangleApp::CreateCommandBuffers()
 {
     mCommandBuffers.resize(MaxFramesInFlight);
@@ -852,6 +1208,10 @@ void HelloTriangleApp::CreateSyncObjects()
             throw std::runtime_error("Failed to create semaphores");
         }
     }
+
+    fenceInfo.flags = 0;
+    if (vkCreateFence(mDevice, &fenceInfo, nullptr, &mUploadFence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create upload fence");
 }
 
 void HelloTriangleApp::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
@@ -877,13 +1237,31 @@ void HelloTriangleApp::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32
     renderPassInfo.pClearValues = std::data(clearValues);
     renderPassInfo.clearValueCount = (uint32_t)std::size(clearValues);
 
+    if (mPagedModel && mAssetState == AssetState::Ready)
+        RecordPageStreaming(commandBuffer);
+    if (mStreamTextures && mAssetState == AssetState::Ready)
+        RecordTextureStreaming(commandBuffer);
+
     vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    // Only the clear until the model and its textures are uploaded
+    if (mAssetState == AssetState::Ready)
+        RecordMeshDraws(commandBuffer);
+
+    vkCmdEndRenderPass(commandBuffer);
+
+    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+        throw std::runtime_error("Failed to record command buffer");
+}
+
+void HelloTriangleApp::RecordMeshDraws(VkCommandBuffer commandBuffer)
+{
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGraphicsPipeline);
 
-    std::array<VkBuffer, 1> vertBuffers = { mVertexBuffer };
-    std::array<VkDeviceSize, 1> offsets = { 0 };
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, std::data(vertBuffers), std::data(offsets));
-    vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer, VkDeviceSize(0), VK_INDEX_TYPE_UINT16);
+    std::array<VkBuffer, 2> vertBuffers = { mVertexBuffer, mVertexBuffer };
+    std::array<VkDeviceSize, 2> offsets = { 0, mVertexAttributeOffset };
+    const uint32_t bindingCount = mVertexLayout.streams == VertexStreams::SplitPosition ? 2 : 1;
+    vkCmdBindVertexBuffers(commandBuffer, 0, bindingCount, std::data(vertBuffers), std::data(offsets));
 
     vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout,
         0, 1, &mDescriptorSets[mCurrentFrame], 0, nullptr);
@@ -902,18 +1280,469 @@ void HelloTriangleApp::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32
     scissor.extent = mSwapChainExtent;
     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
 
-    vkCmdDrawIndexed(commandBuffer, (uint32_t)std::size(mModel->GetMeshes()[0]->GetIndices()), 1, 0, 0, 0);
+    const Frustum frustum = Frustum::FromMatrix(mModelViewProj);
 
-    vkCmdEndRenderPass(commandBuffer);
+    VkIndexType boundIndexType = VK_INDEX_TYPE_MAX_ENUM;
+    uint32_t boundTexture = ~0u;
+    for (const auto& draw : mMeshDraws)
+    {
+        if (draw.indexType != boundIndexType)
+        {
+            const VkDeviceSize offset = draw.indexType == VK_INDEX_TYPE_UINT16 ? 0 : mIndexBuffer32Offset;
+            vkCmdBindIndexBuffer(commandBuffer, mIndexBuffer, offset, draw.indexType);
+            boundIndexType = draw.indexType;
+        }
 
-    if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
-        throw std::runtime_error("Failed to record command buffer");
+        const uint32_t texture = GetMaterialTexture(draw.materialIndex);
+        if (texture != boundTexture)
+        {
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipelineLayout,
+                1, 1, &mTextureDescriptorSets[texture], 0, nullptr);
+            boundTexture = texture;
+        }
+
+        if (mStreamTextures && frustum.IsVisible(draw.bounds))
+            RequestTextureLevel(texture, draw.bounds);
+
+        DrawPushConstants pushConstants;
+        pushConstants.positionOffset = glm::vec4(draw.quantization.offset, 0.0f);
+        pushConstants.positionScale = glm::vec4(draw.quantization.scale, 1.0f);
+        pushConstants.transform = draw.transform;
+        vkCmdPushConstants(commandBuffer, mPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT,
+            0, sizeof(pushConstants), &pushConstants);
+
+        // Allow an error of mLodPixelError pixels on screen at the closest point of the mesh,
+        // LOD errors are in the mesh's own units so they grow with the instance's scale
+        uint32_t firstIndex = draw.firstIndex;
+        uint32_t indexCount = draw.indexCount;
+        if (draw.mesh && !std::empty(draw.mesh->GetLods()))
+        {
+            const float distance = std::max(glm::length(mLodViewPos - draw.bounds.center) - draw.bounds.radius, 0.1f);
+            const float errorScale = mLodErrorScale * Bounds::GetMaxScale(draw.transform);
+            const auto& lod = draw.mesh->GetLods()[draw.mesh->SelectLod(mLodPixelError * distance / errorScale)];
+            firstIndex += lod.firstIndex;
+            indexCount = lod.indexCount;
+        }
+
+        vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, draw.vertexOffset, 0);
+    }
+}
+
+void HelloTriangleApp::RecordPageStreaming(VkCommandBuffer commandBuffer)
+{
+    const auto& pages = mPagedModel->GetPages();
+    const auto& meshPages = mPagedModel->GetMeshPages();
+    const auto& instances = mPagedModel->GetInstances();
+    const auto& worldTransforms = mPagedModel->GetNodes().GetWorldTransforms();
+
+    // Pages of every instance inside the view, nearest first so they get the slots and uploads when there
+    // aren't enough. A page used by several visible instances is uploaded once and drawn for each of them.
+    const Frustum frustum = Frustum::FromMatrix(mModelViewProj);
+    mVisiblePages.clear();
+    for (uint32_t i = 0; i < std::size(instances); ++i)
+    {
+        const auto& transform = worldTransforms[instances[i].nodeIndex];
+        const auto& range = meshPages[instances[i].meshIndex];
+        for (uint32_t page = range.firstPage; page < range.firstPage + range.pageCount; ++page)
+        {
+            const Bounds bounds = pages[page].bounds.Transform(transform);
+            if (frustum.IsVisible(bounds))
+                mVisiblePages.push_back({ page, i, glm::length(bounds.center - mLodViewPos) - bounds.radius });
+        }
+    }
+
+    std::sort(std::begin(mVisiblePages), std::end(mVisiblePages),
+        [](const VisiblePage& a, const VisiblePage& b) { return a.distance < b.distance; });
+
+    const bool packed = mVertexLayout.format == VertexFormat::Packed;
+    const bool split = mVertexLayout.streams == VertexStreams::SplitPosition;
+    const size_t vertexSize = mVertexLayout.GetVertexSize();
+    const size_t positionSize = mVertexLayout.GetPositionSize();
+    const VkDeviceSize slotVertexSize = VkDeviceSize(GeometryPage::MaxVertices * vertexSize);
+    const VkDeviceSize slotIndexSize = VkDeviceSize(GeometryPage::MaxIndices * sizeof(uint16_t));
+
+    std::vector<VkBufferCopy> vertexCopies;
+    std::vector<VkBufferCopy> indexCopies;
+    uint8_t* staging = (uint8_t*)mPageStagingBuffersMapped[mCurrentFrame];
+    uint32_t uploadCount = 0;
+    bool slotsFull = false;
+
+    mMeshDraws.clear();
+    for (const auto& visiblePage : mVisiblePages)
+    {
+        const uint32_t pageIndex = visiblePage.page;
+        const auto& info = pages[pageIndex];
+        uint32_t slotIndex = mPageSlotIndices[pageIndex];
+        if (slotIndex == NoPageSlot)
+        {
+            if (slotsFull || uploadCount == MaxPageUploadsPerFrame)
+                continue;
+
+            slotIndex = FindFreePageSlot();
+            if (slotIndex == NoPageSlot)
+            {
+                slotsFull = true;
+                continue;
+            }
+
+            const auto page = mPageCache->Request(pageIndex);
+            if (!page)
+                continue;
+
+            auto& slot = mPageSlots[slotIndex];
+            if (slot.page != NoPageSlot)
+                mPageSlotIndices[slot.page] = NoPageSlot;
+            slot.page = pageIndex;
+            slot.quantization = packed ? PackedVertex::ComputePositionQuantization(info.bounds) : PositionQuantization{};
+            mPageSlotIndices[pageIndex] = slotIndex;
+
+            const VkDeviceSize stagingOffset = (slotVertexSize + slotIndexSize) * uploadCount;
+            const VkDeviceSize stagingAttrOffset = stagingOffset + VkDeviceSize(GeometryPage::MaxVertices * positionSize);
+            const VkDeviceSize stagingIndexOffset = stagingOffset + slotVertexSize;
+            mVertexLayout.WriteVertices(page->vertices, slot.quantization, staging + stagingOffset, staging + stagingAttrOffset);
+            memcpy(staging + stagingIndexOffset, std::data(page->indices), std::size(page->indices) * sizeof(uint16_t));
+
+            const VkDeviceSize firstVertex = VkDeviceSize(slotIndex) * GeometryPage::MaxVertices;
+            const VkDeviceSize vertexCount = std::size(page->vertices);
+            if (split)
+            {
+                vertexCopies.push_back({ stagingOffset, firstVertex * positionSize, vertexCount * positionSize });
+                vertexCopies.push_back({ stagingAttrOffset, mVertexAttributeOffset + firstVertex * (vertexSize - positionSize),
+                    vertexCount * (vertexSize - positionSize) });
+            }
+            else
+                vertexCopies.push_back({ stagingOffset, firstVertex * vertexSize, vertexCount * vertexSize });
+
+            indexCopies.push_back({ stagingIndexOffset, slotIndexSize * slotIndex, std::size(page->indices) * sizeof(uint16_t) });
+            ++uploadCount;
+        }
+
+        auto& slot = mPageSlots[slotIndex];
+        slot.lastUsedFrame = mFrameCount;
+
+        MeshDrawInfo draw;
+        draw.firstIndex = slotIndex * GeometryPage::MaxIndices;
+        draw.indexCount = info.indexCount;
+        draw.vertexOffset = int32_t(slotIndex * GeometryPage::MaxVertices);
+        draw.indexType = VK_INDEX_TYPE_UINT16;
+        draw.quantization = slot.quantization;
+        draw.materialIndex = info.materialIndex;
+        draw.transform = worldTransforms[instances[visiblePage.instance].nodeIndex];
+        draw.bounds = info.bounds.Transform(draw.transform);
+        mMeshDraws.push_back(draw);
+    }
+
+    if (uploadCount == 0)
+        return;
+
+    vkCmdCopyBuffer(commandBuffer, mPageStagingBuffers[mCurrentFrame], mVertexBuffer,
+        (uint32_t)std::size(vertexCopies), std::data(vertexCopies));
+    vkCmdCopyBuffer(commandBuffer, mPageStagingBuffers[mCurrentFrame], mIndexBuffer,
+        (uint32_t)std::size(indexCopies), std::data(indexCopies));
+
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+uint32_t HelloTriangleApp::FindFreePageSlot() const
+{
+    // A slot can be overwritten once none of the frames in flight draw from it
+    uint32_t bestSlot = NoPageSlot;
+    for (uint32_t i = 0; i < std::size(mPageSlots); ++i)
+    {
+        const auto& slot = mPageSlots[i];
+        if (slot.page == NoPageSlot)
+            return i;
+
+        if (slot.lastUsedFrame + MaxFramesInFlight <= mFrameCount &&
+            (bestSlot == NoPageSlot || slot.lastUsedFrame < mPageSlots[bestSlot].lastUsedFrame))
+        {
+            bestSlot = i;
+        }
+    }
+
+    return bestSlot;
+}
+
+void HelloTriangleApp::RecordTextureStreaming(VkCommandBuffer commandBuffer)
+{
+    constexpr auto noWait = std::chrono::seconds(0);
+
+    ReleaseRetiredTextures(false);
+
+    // Textures whose levels finished reading are resized first.
+    // Evicting takes resizes of its own, one is kept for the texture that asked
+    uint32_t resizeCount = 0;
+    uint32_t pendingReads = 0;
+    for (uint32_t i = 0; i < std::size(mStreamedTextures); ++i)
+    {
+        auto& texture = mStreamedTextures[i];
+        if (!texture.pendingRead.valid())
+            continue;
+
+        const auto& mips = texture.source->GetMips();
+        const VkDeviceSize growth = mips[texture.residentLevel].offset - mips[texture.pendingLevel].offset;
+        const bool evict = mTextureMemoryUsed + growth > mTextureGpuMemory;
+        if (resizeCount + (evict ? 2 : 1) > MaxTextureResizesPerFrame || texture.pendingRead.wait_for(noWait) != std::future_status::ready)
+        {
+            ++pendingReads;
+            continue;
+        }
+
+        const StagedLevels staged = texture.pendingRead.get();
+        if (evict && !EvictStreamedTextures(commandBuffer, growth, i, resizeCount))
+        {
+            // Nothing was recorded from it, it is read again if the draws still want it
+            vkDestroyBuffer(mDevice, staged.stagingBuffer, nullptr);
+            vkFreeMemory(mDevice, staged.stagingBufferMem, nullptr);
+            continue;
+        }
+
+        ResizeStreamedTexture(commandBuffer, i, texture.pendingLevel, staged);
+        ++resizeCount;
+    }
+
+    // Textures the last frame's draws wanted larger start reading, the ones furthest from what they need first.
+    // A texture waits for its previous resize to leave the frames in flight before it is read again
+    std::vector<uint32_t> requests;
+    for (uint32_t i = 0; i < std::size(mStreamedTextures); ++i)
+    {
+        const auto& texture = mStreamedTextures[i];
+        if (texture.source && !texture.pendingRead.valid() && texture.wantedLevel < texture.residentLevel &&
+            texture.lastResizeFrame + MaxFramesInFlight <= mFrameCount)
+        {
+            requests.push_back(i);
+        }
+    }
+
+    std::sort(std::begin(requests), std::end(requests), [this](uint32_t a, uint32_t b) {
+        const auto& textureA = mStreamedTextures[a];
+        const auto& textureB = mStreamedTextures[b];
+        return textureA.residentLevel - textureA.wantedLevel > textureB.residentLevel - textureB.wantedLevel;
+    });
+
+    for (const uint32_t textureIndex : requests)
+    {
+        if (pendingReads >= MaxPendingTextureReads)
+            break;
+
+        ReadStreamedTextureLevels(textureIndex, mStreamedTextures[textureIndex].wantedLevel);
+        ++pendingReads;
+    }
+
+    // This frame's draws ask again
+    for (auto& texture : mStreamedTextures)
+        texture.wantedLevel = texture.tailLevel;
+}
+
+void HelloTriangleApp::ReadStreamedTextureLevels(uint32_t textureIndex, uint32_t level)
+{
+    // The levels are back to back in the source. Touching the mapped cache is what reads them from disk,
+    // so the copy runs on the pool like the page reads and the resize is recorded once it is done
+    auto& texture = mStreamedTextures[textureIndex];
+    const auto& mips = texture.source->GetMips();
+    const VkDeviceSize offset = mips[level].offset;
+    const VkDeviceSize size = mips[texture.residentLevel].offset - offset;
+
+    texture.pendingLevel = level;
+    texture.pendingRead = ThreadPool::Get().Submit([this, pixels = std::data(texture.source->GetPixels()) + offset, size]() {
+        constexpr VkMemoryPropertyFlags stagingProps = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        StagedLevels staged;
+        CreateBuffer(size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, stagingProps, staged.stagingBuffer, staged.stagingBufferMem);
+
+        void* data = nullptr;
+        vkMapMemory(mDevice, staged.stagingBufferMem, 0, size, 0, &data);
+        memcpy(data, pixels, (size_t)size);
+        vkUnmapMemory(mDevice, staged.stagingBufferMem);
+        return staged;
+    });
+}
+
+void HelloTriangleApp::ResizeStreamedTexture(VkCommandBuffer commandBuffer, uint32_t textureIndex, uint32_t level, const StagedLevels& staged)
+{
+    auto& texture = mStreamedTextures[textureIndex];
+    auto& image = mTextureImages[textureIndex];
+    const auto& mips = texture.source->GetMips();
+    const VkFormat format = texture.source->GetFormat();
+    const uint32_t mipCount = (uint32_t)std::size(mips);
+    const uint32_t oldLevel = texture.residentLevel;
+    const uint32_t levelCount = mipCount - level;
+
+    VkImage newImage{};
+    VkDeviceMemory newImageMem{};
+    CreateImage(mips[level].width, mips[level].height, levelCount, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, newImage, newImageMem);
+
+    // Earlier frames may still sample the old image, the barrier waits for them before it is read by the copy
+    std::array<VkImageMemoryBarrier, 2> barriers{};
+    for (auto& barrier : barriers)
+    {
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.layerCount = 1;
+    }
+
+    barriers[0].image = image.mImage;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barriers[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barriers[0].subresourceRange.levelCount = mipCount - oldLevel;
+
+    barriers[1].image = newImage;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers[1].subresourceRange.levelCount = levelCount;
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, (uint32_t)std::size(barriers), std::data(barriers));
+
+    // Levels both images have are copied on the GPU
+    std::vector<VkImageCopy> imageCopies;
+    for (uint32_t mip = std::max(level, oldLevel); mip < mipCount; ++mip)
+    {
+        VkImageCopy copy{};
+        copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - oldLevel, 0, 1 };
+        copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - level, 0, 1 };
+        copy.extent = { mips[mip].width, mips[mip].height, 1 };
+        imageCopies.push_back(copy);
+    }
+    vkCmdCopyImage(commandBuffer, image.mImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        (uint32_t)std::size(imageCopies), std::data(imageCopies));
+
+    // Levels the old image didn't have are uploaded from the staging buffer their read filled
+    if (level < oldLevel)
+    {
+        std::vector<VkBufferImageCopy> regions;
+        for (uint32_t mip = level; mip < oldLevel; ++mip)
+        {
+            VkBufferImageCopy region{};
+            region.bufferOffset = mips[mip].offset - mips[level].offset;
+            region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, mip - level, 0, 1 };
+            region.imageExtent = { mips[mip].width, mips[mip].height, 1 };
+            regions.push_back(region);
+        }
+        vkCmdCopyBufferToImage(commandBuffer, staged.stagingBuffer, newImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            (uint32_t)std::size(regions), std::data(regions));
+    }
+
+    VkImageMemoryBarrier readBarrier = barriers[1];
+    readBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    readBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    readBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    readBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &readBarrier);
+
+    // The descriptor set of a frame in flight can't be updated, so the texture gets a new one
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = mTextureDescriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &mTextureSetLayout;
+
+    VkDescriptorSet descriptorSet{};
+    if (vkAllocateDescriptorSets(mDevice, &allocInfo, &descriptorSet) != VK_SUCCESS)
+        throw std::runtime_error("Failed to allocate texture descriptor set");
+
+    const VkImageView imageView = CreateImageView(newImage, format, VK_IMAGE_ASPECT_COLOR_BIT, levelCount);
+    WriteTextureDescriptorSet(descriptorSet, imageView);
+
+    // The staging buffer is read by this frame's copy, so it retires with the old image
+    mRetiredTextures.push_back({ image.mImage, image.mImageMem, image.mImageView, mTextureDescriptorSets[textureIndex],
+        staged.stagingBuffer, staged.stagingBufferMem, mFrameCount });
+    image.mImage = newImage;
+    image.mImageMem = newImageMem;
+    image.mImageView = imageView;
+    mTextureDescriptorSets[textureIndex] = descriptorSet;
+    mTextureMipLevels[textureIndex] = levelCount;
+
+    const VkDeviceSize size = mips.back().offset + mips.back().size - mips[level].offset;
+    mTextureMemoryUsed = mTextureMemoryUsed - texture.residentSize + size;
+    texture.residentSize = size;
+    texture.residentLevel = level;
+    texture.lastResizeFrame = mFrameCount;
+}
+
+bool HelloTriangleApp::EvictStreamedTextures(VkCommandBuffer commandBuffer, VkDeviceSize bytes, uint32_t keepIndex, uint32_t& resizeCount)
+{
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < std::size(mStreamedTextures); ++i)
+    {
+        const auto& texture = mStreamedTextures[i];
+        if (i != keepIndex && texture.source && !texture.pendingRead.valid() && texture.wantedLevel > texture.residentLevel &&
+            texture.lastResizeFrame + MaxFramesInFlight <= mFrameCount)
+        {
+            candidates.push_back(i);
+        }
+    }
+
+    std::sort(std::begin(candidates), std::end(candidates), [this](uint32_t a, uint32_t b) {
+        return mStreamedTextures[a].lastUsedFrame < mStreamedTextures[b].lastUsedFrame;
+    });
+
+    // Shrinking only copies from the old image, nothing is staged
+    for (const uint32_t textureIndex : candidates)
+    {
+        if (mTextureMemoryUsed + bytes <= mTextureGpuMemory || resizeCount + 1 >= MaxTextureResizesPerFrame)
+            break;
+
+        ResizeStreamedTexture(commandBuffer, textureIndex, mStreamedTextures[textureIndex].wantedLevel, {});
+        ++resizeCount;
+    }
+
+    return mTextureMemoryUsed + bytes <= mTextureGpuMemory;
+}
+
+void HelloTriangleApp::RequestTextureLevel(uint32_t textureIndex, const Bounds& bounds)
+{
+    if (textureIndex >= std::size(mStreamedTextures) || !mStreamedTextures[textureIndex].source)
+        return;
+
+    // Assumes the texture is stretched once over the mesh, so it needs about as many texels as the bounds cover pixels
+    auto& texture = mStreamedTextures[textureIndex];
+    const auto& fullMip = texture.source->GetMips()[0];
+    const float distance = std::max(glm::length(mLodViewPos - bounds.center) - bounds.radius, 0.1f);
+    const float pixels = std::max(2.0f * bounds.radius * mLodErrorScale / distance, 1.0f);
+    const float texels = (float)std::max(fullMip.width, fullMip.height);
+    const uint32_t level = pixels >= texels ? 0 : (uint32_t)std::log2(texels / pixels);
+
+    texture.wantedLevel = std::max(std::min(texture.wantedLevel, level), texture.topLevel);
+    texture.lastUsedFrame = mFrameCount;
+}
+
+void HelloTriangleApp::ReleaseRetiredTextures(bool all)
+{
+    const auto released = std::remove_if(std::begin(mRetiredTextures), std::end(mRetiredTextures), [this, all](const RetiredTexture& retired) {
+        if (!all && retired.frame + MaxFramesInFlight > mFrameCount)
+            return false;
+
+        vkDestroyImageView(mDevice, retired.imageView, nullptr);
+        vkDestroyImage(mDevice, retired.image, nullptr);
+        vkFreeMemory(mDevice, retired.imageMem, nullptr);
+        vkFreeDescriptorSets(mDevice, mTextureDescriptorPool, 1, &retired.descriptorSet);
+        vkDestroyBuffer(mDevice, retired.stagingBuffer, nullptr);
+        vkFreeMemory(mDevice, retired.stagingBufferMem, nullptr);
+        return true;
+    });
+    mRetiredTextures.erase(released, std::end(mRetiredTextures));
 }
 
 void HelloTriangleApp::DrawFrame()
 {
     constexpr uint64_t timeout = UINT64_MAX;
 
+    UpdateAssetLoading();
+
     vkWaitForFences(mDevice, 1, &mInFlightFences[mCurrentFrame], VK_TRUE, timeout);
 
     uint32_t imageIndex = 0;
@@ -928,6 +1757,7 @@ void HelloTriangleApp::DrawFrame()
 
     vkResetFences(mDevice, 1, &mInFlightFences[mCurrentFrame]);
 
+    ++mFrameCount;
     UpdateUniformBuffer(mCurrentFrame);
 
     vkResetCommandBuffer(mCommandBuffers[mCurrentFrame], 0);
@@ -969,9 +1799,257 @@ void HelloTriangleApp::DrawFrame()
     else if (result != VK_SUCCESS)
         throw std::runtime_error("Failed to present swap chain image");
 
+    if (!mFirstFramePresented)
+    {
+        mFirstFramePresented = true;
+        LOG_INFO("First frame presented after {0} ms", GetElapsedMs());
+    }
+
     mCurrentFrame = (mCurrentFrame + 1) % MaxFramesInFlight;
 }
 
+void HelloTriangleApp::UpdateAssetLoading()
+{
+    constexpr auto noWait = std::chrono::seconds(0);
+
+    if (mAssetState == AssetState::LoadingModel && mStreamModel && mPagedModelFuture.wait_for(noWait) == std::future_status::ready)
+    {
+        mPagedModel = mPagedModelFuture.get();
+        if (!mPagedModel)
+            throw std::runtime_error("Failed to load model");
+
+        LOG_INFO("Model opened for streaming after {0} ms", GetElapsedMs());
+        StartTextureLoading(mPagedModel->GetTexturePaths());
+    }
+
+    if (mAssetState == AssetState::LoadingModel && !mStreamModel && mModelFuture.wait_for(noWait) == std::future_status::ready)
+    {
+        mModel = mModelFuture.get();
+        if (!mModel)
+            throw std::runtime_error("Failed to load model");
+
+        LOG_INFO("Model loaded after {0} ms", GetElapsedMs());
+        StartTextureLoading(mModel->GetTexturePaths());
+    }
+
+    if (mAssetState == AssetState::LoadingTexture)
+    {
+        UploadReadyTextures();
+        if (mPendingTextures == 0)
+        {
+            LOG_INFO("Textures loaded after {0} ms, {1} textures took {2} ms on {3} pool threads", GetElapsedMs(),
+                std::size(mTextureFutures), GetElapsedMs() - mTextureLoadStartMs, ThreadPool::Get().GetThreadCount());
+            StartAssetUpload();
+        }
+    }
+
+    if (mAssetState == AssetState::Uploading && vkGetFenceStatus(mDevice, mUploadFence) == VK_SUCCESS)
+        FinishAssetUpload();
+}
+
+void HelloTriangleApp::StartTextureLoading(const std::vector<std::string>& texturePaths)
+{
+    if (mTextureLoadBench)
+        BenchmarkTextureLoading(texturePaths);
+
+    // Every texture decodes, builds its mips and fills its staging buffer in its own job,
+    // a missing texture falls back to white instead of failing the load
+    mTextureImages.resize(std::size(texturePaths) + 1);
+    mTextureMipLevels.resize(std::size(texturePaths) + 1);
+    mTextureFormats.resize(std::size(texturePaths) + 1);
+
+    if (mStreamTextures)
+    {
+        mStreamedTextures.clear();
+        mStreamedTextures.resize(std::size(texturePaths));
+    }
+
+    mTextureLoadStartMs = GetElapsedMs();
+    mTextureFutures.clear();
+    for (const auto& texturePath : texturePaths)
+    {
+        mTextureFutures.push_back(ThreadPool::Get().Submit([this, texturePath, options = mTextureLoadOptions]() {
+            StagedTexture texture;
+            texture.image = Image::Load(texturePath, options);
+            if (!texture.image)
+                return texture;
+
+            // Only textures mapped from the cache with their whole chain are streamed, the levels above
+            // the tail are then read from disk when they are streamed in instead of being held in memory
+            const auto& mips = texture.image->GetMips();
+            texture.stream = mStreamTextures && texture.image->IsMapped() &&
+                std::size(mips) == Image::GetMipCount(texture.image->GetWidth(), texture.image->GetHeight());
+            if (texture.stream)
+            {
+                while (texture.firstLevel + 1 < std::size(mips) &&
+                    std::max(mips[texture.firstLevel].width, mips[texture.firstLevel].height) > mTextureTailSize)
+                {
+                    ++texture.firstLevel;
+                }
+
+                // A level whose chain down to 1x1 is larger than the budget could never be resident
+                const VkDeviceSize chainEnd = mips.back().offset + mips.back().size;
+                while (texture.topLevel < texture.firstLevel && chainEnd - mips[texture.topLevel].offset > mTextureGpuMemory)
+                    ++texture.topLevel;
+                if (texture.topLevel > 0)
+                {
+                    LOG_WARN("Texture {0} is larger than textureGpuMemoryMB, only streams up to {1}x{2}", texturePath,
+                        mips[texture.topLevel].width, mips[texture.topLevel].height);
+                }
+            }
+
+            StageTexture(texture);
+            return texture;
+        }));
+    }
+    mPendingTextures = std::size(mTextureFutures);
+
+    // Stays open across frames, the copies are recorded as the jobs finish and the rest of the upload at the end
+    mUploadCommandBuffer = BeginSingleTimeCommands();
+    mAssetState = AssetState::LoadingTexture;
+}
+
+void HelloTriangleApp::BenchmarkTextureLoading(const std::vector<std::string>& texturePaths)
+{
+    ImageLoadOptions options = mTextureLoadOptions;
+    options.useCache = false;
+
+    // Mip generation and compression split their work through ThreadPool::Get, which gives them the pool
+    // the texture job runs on, so each pass uses exactly that many threads
+    const uint32_t maxThreadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threadCount = 1; ; threadCount = std::min(threadCount * 2, maxThreadCount))
+    {
+        ThreadPool pool(threadCount);
+        const float startMs = GetElapsedMs();
+
+        std::vector<std::future<bool>> loads;
+        for (const auto& texturePath : texturePaths)
+            loads.push_back(pool.Submit([texturePath, options]() { return Image::Load(texturePath, options) != nullptr; }));
+
+        size_t loadedCount = 0;
+        for (auto& load : loads)
+            loadedCount += load.get() ? 1 : 0;
+
+        LOG_INFO("Texture load benchmark: {0} of {1} textures in {2:.1f} ms on {3} threads", loadedCount, std::size(texturePaths),
+            GetElapsedMs() - startMs, threadCount);
+
+        if (threadCount == maxThreadCount)
+            break;
+    }
+}
+
+void HelloTriangleApp::UploadReadyTextures()
+{
+    constexpr auto noWait = std::chrono::seconds(0);
+
+    mRecordingUpload = true;
+    for (size_t i = 0; i < std::size(mTextureFutures); ++i)
+    {
+        auto& future = mTextureFutures[i];
+        if (!future.valid() || future.wait_for(noWait) != std::future_status::ready)
+            continue;
+
+        auto texture = future.get();
+        if (texture.image)
+        {
+            CreateTextureImage(texture, mTextureImages[i], mTextureMipLevels[i]);
+            mTextureFormats[i] = texture.image->GetFormat();
+
+            if (texture.stream)
+            {
+                const auto& mips = texture.image->GetMips();
+                auto& streamed = mStreamedTextures[i];
+                streamed.residentLevel = texture.firstLevel;
+                streamed.tailLevel = texture.firstLevel;
+                streamed.topLevel = texture.topLevel;
+                streamed.wantedLevel = texture.firstLevel;
+                streamed.residentSize = mips.back().offset + mips.back().size - mips[texture.firstLevel].offset;
+                streamed.source = std::move(texture.image);
+                mTextureMemoryUsed += streamed.residentSize;
+            }
+        }
+        --mPendingTextures;
+    }
+    mRecordingUpload = false;
+}
+
+uint32_t HelloTriangleApp::GetMaterialTexture(uint32_t materialIndex) const
+{
+    const uint32_t fallback = (uint32_t)std::size(mTextureImages) - 1;
+    if (materialIndex >= std::size(mMaterials))
+        return fallback;
+
+    const uint32_t texture = mMaterials[materialIndex].diffuseTexture;
+    return texture < fallback ? texture : fallback;
+}
+
+void HelloTriangleApp::StartAssetUpload()
+{
+    mMaterials = mPagedModel ? mPagedModel->GetMaterials() : mModel->GetMaterials();
+
+    mRecordingUpload = true;
+
+    CreateTextureImages();
+    CreateTextureImageViews();
+    CreateTextureSampler();
+    if (mStreamTextures)
+    {
+        const auto streamedCount = std::count_if(std::begin(mStreamedTextures), std::end(mStreamedTextures), [](const StreamedTexture& texture) {
+            return texture.source != nullptr;
+        });
+        LOG_INFO("Streaming {0} textures, {1:.1f} MB resident at startup", streamedCount, mTextureMemoryUsed / (1024.0f * 1024.0f));
+    }
+    if (mPagedModel)
+    {
+        CreatePageBuffers();
+    }
+    else
+    {
+        CreateVertexBuffer();
+        CreateIndexBuffer();
+    }
+
+    // Make the buffer copies visible to the vertex input of the frames that draw the model
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+    vkCmdPipelineBarrier(mUploadCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+        0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    mRecordingUpload = false;
+    vkEndCommandBuffer(mUploadCommandBuffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pCommandBuffers = &mUploadCommandBuffer;
+    submitInfo.commandBufferCount = 1;
+
+    if (vkQueueSubmit(mGraphicsQueue, 1, &submitInfo, mUploadFence) != VK_SUCCESS)
+        throw std::runtime_error("Failed to submit upload command buffer");
+
+    mTextureFutures.clear();
+    mAssetState = AssetState::Uploading;
+}
+
+void HelloTriangleApp::FinishAssetUpload()
+{
+    for (const auto& [buffer, bufferMem] : mUploadStagingBuffers)
+    {
+        vkDestroyBuffer(mDevice, buffer, nullptr);
+        vkFreeMemory(mDevice, bufferMem, nullptr);
+    }
+    mUploadStagingBuffers.clear();
+
+    vkFreeCommandBuffers(mDevice, mCommandPool, 1, &mUploadCommandBuffer);
+    mUploadCommandBuffer = VK_NULL_HANDLE;
+
+    CreateTextureDescriptorSets();
+
+    mAssetState = AssetState::Ready;
+    LOG_INFO("Model ready to draw after {0} ms", GetElapsedMs());
+}
+
 void HelloTriangleApp::RecreateSwapChain()
 {
     int width = 0;
@@ -1192,6 +2270,18 @@ void HelloTriangleApp::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDevi
     EndSingleTimeCommands(commandBuffer);
 }
 
+void HelloTriangleApp::DestroyStagingBuffer(VkBuffer buffer, VkDeviceMemory bufferMem)
+{
+    if (mRecordingUpload)
+    {
+        mUploadStagingBuffers.emplace_back(buffer, bufferMem);
+        return;
+    }
+
+    vkDestroyBuffer(mDevice, buffer, nullptr);
+    vkFreeMemory(mDevice, bufferMem, nullptr);
+}
+
 void HelloTriangleApp::UpdateUniformBuffer(uint32_t curImage)
 {
     static auto startTime = std::chrono::high_resolution_clock::now();
@@ -1205,6 +2295,10 @@ void HelloTriangleApp::UpdateUniformBuffer(uint32_t curImage)
         mSwapChainExtent.width / (float)mSwapChainExtent.height, 0.1f, 10.0f);
     ubo.proj[1][1] *= -1.0f;
 
+    mLodViewPos = glm::vec3(glm::inverse(ubo.view * ubo.model)[3]);
+    mModelViewProj = ubo.proj * ubo.view * ubo.model;
+    mLodErrorScale = std::abs(ubo.proj[1][1]) * mSwapChainExtent.height * 0.5f;
+
     memcpy(mUniformBuffersMapped[curImage], &ubo, sizeof(ubo));
 }
 
@@ -1286,17 +2380,24 @@ void HelloTriangleApp::TransitionImageLayout(VkImage image, VkFormat format, VkI
     EndSingleTimeCommands(commandBuffer);
 }
 
-void HelloTriangleApp::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+void HelloTriangleApp::CopyBufferToImage(VkBuffer buffer, VkImage image, const std::vector<ImageMip>& mips)
 {
     VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
 
-    VkBufferImageCopy region{};
-    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    region.imageSubresource.layerCount = 1;
-    region.imageOffset = { 0, 0, 0 };
-    region.imageExtent = { width, height, 1 };
+    // One region per mip level, the buffer holds the levels back to back
+    std::vector<VkBufferImageCopy> regions(std::size(mips));
+    for (size_t i = 0; i < std::size(mips); ++i)
+    {
+        auto& region = regions[i];
+        region.bufferOffset = mips[i].offset;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = (uint32_t)i;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { mips[i].width, mips[i].height, 1 };
+    }
 
-    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+    vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, (uint32_t)std::size(regions), std::data(regions));
 
     EndSingleTimeCommands(commandBuffer);
 }
@@ -1399,6 +2500,9 @@ void HelloTriangleApp::GenerateMipmaps(VkImage image, VkFormat imageFormat, uint
 
 VkCommandBuffer HelloTriangleApp::BeginSingleTimeCommands()
 {
+    if (mRecordingUpload)
+        return mUploadCommandBuffer;
+
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -1419,6 +2523,10 @@ VkCommandBuffer HelloTriangleApp::BeginSingleTimeCommands()
 
 void HelloTriangleApp::EndSingleTimeCommands(VkCommandBuffer commandBuffer)
 {
+    // Submitted together with the rest of the upload by StartAssetUpload
+    if (mRecordingUpload)
+        return;
+
     vkEndCommandBuffer(commandBuffer);
 
     VkSubmitInfo submitInfo{};
@@ -1443,6 +2551,11 @@ bool HelloTriangleApp::HasStencilComponent(VkFormat format) const
     return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
+float HelloTriangleApp::GetElapsedMs() const
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - mStartTime).count();
+}
+
 void HelloTriangleApp::FramebufferResizeCallback(GLFWwindow* window, int width, int height)
 {
     auto app = (HelloTriangleApp*)glfwGetWindowUserPointer(window);
@@ -4,11 +4,20 @@
 #include <vector>
 #include <array>
 #include <memory>
+#include <future>
+#include <chrono>
+#include <string>
 
 #include <vulkan/vulkan.h>
 
 #include "Vertex.h"
 #include "Model.h"
+#include "Material.h"
+#include "MeshDrawInfo.h"
+#include "VertexLayout.h"
+#include "Image.h"
+#include "PagedModel.h"
+#include "PageCache.h"
 
 #include "Vulkan/VulkanImage.h"
 
@@ -49,11 +58,14 @@ private:
     void CreateCommandPool();
     void CreateColorResources();
     void CreateDepthResources();
-    void CreateTextureImage();
-    void CreateTextureImageView();
+    void CreateTextureImages();
+    void CreateTextureImageViews();
     void CreateTextureSampler();
+    void CreateTextureDescriptorSets();
+    void WriteTextureDescriptorSet(VkDescriptorSet descriptorSet, VkImageView imageView);
     void CreateVertexBuffer();
     void CreateIndexBuffer();
+    void CreatePageBuffers();
     void CreateUniformBuffers();
     void CreateDescriptorPool();
     void CreateDescriptorSets();
@@ -61,6 +73,38 @@ private:
     void CreateSyncObjects();
 
     void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+    void RecordMeshDraws(VkCommandBuffer commandBuffer);
+    void RecordPageStreaming(VkCommandBuffer commandBuffer);
+    uint32_t FindFreePageSlot() const;
+    void RecordTextureStreaming(VkCommandBuffer commandBuffer);
+    // Levels of a streamed texture a pool job read into their own staging buffer, back to back from the largest
+    struct StagedLevels
+    {
+        VkBuffer stagingBuffer{};
+        VkDeviceMemory stagingBufferMem{};
+    };
+    // Reads the levels from level up to the resident one into a staging buffer of their own on the pool
+    void ReadStreamedTextureLevels(uint32_t textureIndex, uint32_t level);
+    // Recreates a streamed texture with the levels from level down resident, the levels it already had are
+    // copied from the old image and the rest from the staging buffer its read filled
+    void ResizeStreamedTexture(VkCommandBuffer commandBuffer, uint32_t textureIndex, uint32_t level, const StagedLevels& staged);
+    // Shrinks textures drawn smaller than their resident size, least recently used first, until bytes more fit the budget
+    bool EvictStreamedTextures(VkCommandBuffer commandBuffer, VkDeviceSize bytes, uint32_t keepIndex, uint32_t& resizeCount);
+    void RequestTextureLevel(uint32_t textureIndex, const Bounds& bounds);
+    // Destroys images, descriptor sets and staging buffers of a resize once no frame in flight uses them, or all of them
+    void ReleaseRetiredTextures(bool all);
+
+    void UpdateAssetLoading();
+    void StartTextureLoading(const std::vector<std::string>& texturePaths);
+    // Loads the textures without the cache on pools of 1 thread up to the hardware thread count and logs
+    // the wall time of each. Blocks until done, the textures aren't kept
+    void BenchmarkTextureLoading(const std::vector<std::string>& texturePaths);
+    void UploadReadyTextures();
+    void StartAssetUpload();
+    void FinishAssetUpload();
+
+    // Texture descriptor set for a material, the fallback set for missing materials and textures
+    uint32_t GetMaterialTexture(uint32_t materialIndex) const;
 
     void RecreateSwapChain();
     void CleanupSwapChain();
@@ -79,11 +123,27 @@ private:
     void CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props,
         VkBuffer& buffer, VkDeviceMemory& bufferMem);
     void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+    void DestroyStagingBuffer(VkBuffer buffer, VkDeviceMemory bufferMem);
     void UpdateUniformBuffer(uint32_t curImage);
     void CreateImage(uint32_t width, uint32_t height, uint32_t mipLevels, VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
         VkImageUsageFlags usage, VkMemoryPropertyFlags props, VkImage& image, VkDeviceMemory& imageMem);
     void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
-    void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+    void CopyBufferToImage(VkBuffer buffer, VkImage image, const std::vector<ImageMip>& mips);
+    // A decoded texture copied into a staging buffer, produced by a pool job
+    struct StagedTexture
+    {
+        std::unique_ptr<Image> image;
+        // Largest level uploaded, only the mip tail is staged when the texture is streamed
+        uint32_t firstLevel = 0;
+        bool stream = false;
+        // Largest level a streamed texture can grow to within the memory budget
+        uint32_t topLevel = 0;
+        VkBuffer stagingBuffer{};
+        VkDeviceMemory stagingBufferMem{};
+    };
+    // Only creates and fills the staging buffer so it can be called from pool jobs
+    void StageTexture(StagedTexture& texture);
+    void CreateTextureImage(const StagedTexture& texture, VulkanImage& image, uint32_t& mipLevels);
 
     VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
 
@@ -95,6 +155,8 @@ private:
     VkFormat FindDepthFormat() const;
     bool HasStencilComponent(VkFormat format) const;
 
+    float GetElapsedMs() const;
+
     static void FramebufferResizeCallback(GLFWwindow* window, int width, int height);
 
 private:
@@ -120,6 +182,7 @@ private:
 
     VkRenderPass mRenderPass{};
     VkDescriptorSetLayout mDescriptorSetLayout{};
+    VkDescriptorSetLayout mTextureSetLayout{};
     VkPipelineLayout mPipelineLayout{};
     VkPipeline mGraphicsPipeline{};
 
@@ -132,9 +195,55 @@ private:
 
     VkBuffer mVertexBuffer{};
     VkDeviceMemory mVertexBufferMem{};
+    // Start of the non-position attributes when the position stream is split out
+    VkDeviceSize mVertexAttributeOffset = 0;
 
     VkBuffer mIndexBuffer{};
     VkDeviceMemory mIndexBufferMem{};
+    VkDeviceSize mIndexBuffer32Offset = 0;
+
+    std::vector<MeshDrawInfo> mMeshDraws;
+
+    // Out of core path. Visible pages are read through mPageCache and copied into fixed size slots
+    // of the vertex and index buffers, slots not used by a frame in flight are reused least recently used first.
+    static constexpr uint32_t NoPageSlot = ~0u;
+    static constexpr uint32_t MaxPageUploadsPerFrame = 8;
+
+    struct PageSlot
+    {
+        uint32_t page = NoPageSlot;
+        uint64_t lastUsedFrame = 0;
+        PositionQuantization quantization;
+    };
+
+    struct VisiblePage
+    {
+        uint32_t page = 0;
+        uint32_t instance = 0;
+        float distance = 0.0f;
+    };
+
+    bool mStreamModel = false;
+    size_t mPageCacheMemory = 0;
+    size_t mPageGpuMemory = 0;
+    std::unique_ptr<PagedModel> mPagedModel;
+    std::unique_ptr<PageCache> mPageCache;
+    std::vector<PageSlot> mPageSlots;
+    // Slot holding each page, NoPageSlot when it isn't on the GPU
+    std::vector<uint32_t> mPageSlotIndices;
+    std::vector<VisiblePage> mVisiblePages;
+    std::vector<VkBuffer> mPageStagingBuffers;
+    std::vector<VkDeviceMemory> mPageStagingBuffersMem;
+    std::vector<void*> mPageStagingBuffersMapped;
+    uint64_t mFrameCount = 0;
+
+    // Camera position in model space and pixels per unit of error at a distance of one, for LOD selection
+    glm::vec3 mLodViewPos{ 0.0f };
+    float mLodErrorScale = 1.0f;
+    float mLodPixelError = 1.0f;
+
+    // Model space to clip space, for culling pages
+    glm::mat4 mModelViewProj{ 1.0f };
 
     std::vector<VkBuffer> mUniformBuffers;
     std::vector<VkDeviceMemory> mUniformBuffersMem;
@@ -143,9 +252,17 @@ private:
     VkDescriptorPool mDescriptorPool{};
     std::vector<VkDescriptorSet> mDescriptorSets;
 
-    uint32_t mMipLevels = 0;
-    VulkanImage mTexImage;
+    // One image and descriptor set per unique texture of the model, plus a white fallback at the end
+    std::vector<VulkanImage> mTextureImages;
+    std::vector<uint32_t> mTextureMipLevels;
+    std::vector<VkFormat> mTextureFormats;
+    VkDescriptorPool mTextureDescriptorPool{};
+    std::vector<VkDescriptorSet> mTextureDescriptorSets;
     VkSampler mTexSampler{};
+    // Cooked texture cache, CPU mips and BC compression. Compression is turned off when the device can't sample BC formats
+    ImageLoadOptions mTextureLoadOptions;
+    bool mTextureLoadBench = false;
+    std::vector<Material> mMaterials;
 
     VulkanImage mDepthImage;
 
@@ -153,7 +270,81 @@ private:
 
     VkDebugUtilsMessengerEXT mDebugMessenger{};
 
+    // The model and its textures load on the thread pool while frames are already being presented,
+    // the draws are swapped in once the upload fence has signaled
+    enum class AssetState
+    {
+        LoadingModel,
+        LoadingTexture,
+        Uploading,
+        Ready
+    };
+
+    AssetState mAssetState = AssetState::LoadingModel;
+    std::future<std::unique_ptr<Model>> mModelFuture;
+    std::future<std::unique_ptr<PagedModel>> mPagedModelFuture;
+    // One job per texture, a job's copy is recorded into mUploadCommandBuffer as soon as it is ready.
+    // Futures are left invalid once recorded, textures that failed to load come back without an image
+    std::vector<std::future<StagedTexture>> mTextureFutures;
+    size_t mPendingTextures = 0;
+    float mTextureLoadStartMs = 0.0f;
+
+    // Texture streaming. Only the levels up to mTextureTailSize are uploaded at first, larger levels are streamed
+    // in when draws get close enough to need them and textures drawn smaller than their resident size shrink again
+    // when mTextureGpuMemory runs out. A resize recreates the image so only resident levels take up memory.
+    static constexpr uint32_t MaxTextureResizesPerFrame = 4;
+    // Level reads in flight at once, each holds its staging buffer until its resize is recorded
+    static constexpr uint32_t MaxPendingTextureReads = 4;
+
+    struct StreamedTexture
+    {
+        // Mapped from the texture cache, levels that are never streamed in are never read from disk
+        std::unique_ptr<Image> source;
+        // Largest level on the GPU, the tail level is never evicted
+        uint32_t residentLevel = 0;
+        uint32_t tailLevel = 0;
+        uint32_t topLevel = 0;
+        // Largest level the draws of the last frame asked for
+        uint32_t wantedLevel = 0;
+        uint64_t lastUsedFrame = 0;
+        uint64_t lastResizeFrame = 0;
+        VkDeviceSize residentSize = 0;
+        // Levels from pendingLevel up to the resident one being read, the texture isn't resized meanwhile
+        std::future<StagedLevels> pendingRead;
+        uint32_t pendingLevel = 0;
+    };
+
+    struct RetiredTexture
+    {
+        VkImage image{};
+        VkDeviceMemory imageMem{};
+        VkImageView imageView{};
+        VkDescriptorSet descriptorSet{};
+        VkBuffer stagingBuffer{};
+        VkDeviceMemory stagingBufferMem{};
+        uint64_t frame = 0;
+    };
+
+    bool mStreamTextures = false;
+    uint32_t mTextureTailSize = 128;
+    VkDeviceSize mTextureGpuMemory = 0;
+    VkDeviceSize mTextureMemoryUsed = 0;
+    // Indexed like mTextureImages without the fallback, textures that failed to load have no source
+    std::vector<StreamedTexture> mStreamedTextures;
+    std::vector<RetiredTexture> mRetiredTextures;
+
+    // While recording the upload the single time command helpers record into mUploadCommandBuffer
+    // and staging buffers are kept alive until mUploadFence signals
+    bool mRecordingUpload = false;
+    VkCommandBuffer mUploadCommandBuffer{};
+    VkFence mUploadFence{};
+    std::vector<std::pair<VkBuffer, VkDeviceMemory>> mUploadStagingBuffers;
+
+    std::chrono::steady_clock::time_point mStartTime;
+    bool mFirstFramePresented = false;
+
     std::unique_ptr<Model> mModel;
+    VertexLayout mVertexLayout;
 
     VkSampleCountFlagBits mMsaaSamples = VK_SAMPLE_COUNT_1_BIT;
 
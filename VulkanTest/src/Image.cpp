@@ -0,0 +1,217 @@
+#include "Image.h"
+
+#include <stb_image.h>
+
+#include "TextureCache.h"
+#include "BlockCompression.h"
+#include "MipGenerator.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+    constexpr uint32_t BytesPerPixel = 4;
+
+    VkFormat GetCompressedFormat(TextureCompression compression, const Image& image)
+    {
+        if (compression == TextureCompression::None)
+            return image.GetFormat();
+
+        // BC5 would drop the blue and alpha of a color image, and sRGB formats would bend normals
+        if (image.IsTwoChannel())
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+
+        switch (compression)
+        {
+        case TextureCompression::BC1: return image.HasAlpha() ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        case TextureCompression::BC5:
+        case TextureCompression::BC7: return VK_FORMAT_BC7_SRGB_BLOCK;
+        default: return image.GetFormat();
+        }
+    }
+}
+
+void Image::GenerateMips(bool srgb)
+{
+    const uint32_t mipCount = GetMipCount(mWidth, mHeight);
+    if (std::size(mMips) == mipCount || BlockCompression::IsBlockCompressed(mFormat))
+        return;
+
+    // The full size level has to be in mPixels so the rest of the chain can be appended
+    if (std::data(mPixelView) != std::data(mPixels))
+        mPixels.assign(std::begin(mPixelView), std::begin(mPixelView) + mMips[0].size);
+
+    mMips.resize(1);
+    uint64_t offset = mMips[0].size;
+    for (uint32_t level = 1; level < mipCount; ++level)
+    {
+        const ImageMip& previous = mMips.back();
+        ImageMip mip;
+        mip.width = std::max(previous.width / 2, 1u);
+        mip.height = std::max(previous.height / 2, 1u);
+        mip.offset = offset;
+        mip.size = uint64_t(mip.width) * mip.height * BytesPerPixel;
+        offset += mip.size;
+        mMips.push_back(mip);
+    }
+
+    mPixels.resize(offset);
+    for (uint32_t level = 1; level < mipCount; ++level)
+    {
+        const ImageMip& src = mMips[level - 1];
+        const ImageMip& dst = mMips[level];
+        MipGenerator::Downsample(std::data(mPixels) + src.offset, src.width, src.height, std::data(mPixels) + dst.offset, dst.width, dst.height, srgb);
+    }
+    mPixelView = mPixels;
+}
+
+void Image::Compress(VkFormat format)
+{
+    if (format == mFormat || BlockCompression::IsBlockCompressed(mFormat))
+        return;
+
+    std::vector<ImageMip> mips;
+    uint64_t offset = 0;
+    for (const auto& src : mMips)
+    {
+        const uint64_t size = BlockCompression::GetImageSize(format, src.width, src.height);
+        mips.push_back({ src.width, src.height, offset, size });
+        offset += size;
+    }
+
+    std::vector<uint8_t> pixels(offset);
+    for (size_t level = 0; level < std::size(mMips); ++level)
+    {
+        BlockCompression::CompressImage(std::data(mPixelView) + mMips[level].offset, mMips[level].width, mMips[level].height,
+            format, std::data(pixels) + mips[level].offset);
+    }
+
+    mPixels = std::move(pixels);
+    mPixelView = mPixels;
+    mMips = std::move(mips);
+    mMappedFile.reset();
+    mFormat = format;
+}
+
+bool Image::HasAlpha() const
+{
+    if (BlockCompression::IsBlockCompressed(mFormat) || std::empty(mMips))
+        return false;
+
+    const uint8_t* pixels = std::data(mPixelView) + mMips[0].offset;
+    for (uint64_t i = 3; i < mMips[0].size; i += BytesPerPixel)
+    {
+        if (pixels[i] != 255)
+            return true;
+    }
+    return false;
+}
+
+bool Image::IsTwoChannel() const
+{
+    if (BlockCompression::IsBlockCompressed(mFormat) || std::empty(mMips))
+        return false;
+
+    // Normals are mapped from [-1, 1] to [0, 255], so twice a channel minus 255 is the component scaled by 255.
+    // Lengths within 10% of one pass, a few outliers are allowed for pixels the source encoder rounded badly
+    constexpr int32_t UnitLength = 255 * 255;
+    constexpr int32_t MinLength = UnitLength * 8 / 10;
+    constexpr int32_t MaxLength = UnitLength * 12 / 10;
+
+    const uint8_t* pixels = std::data(mPixelView) + mMips[0].offset;
+    const uint64_t pixelCount = mMips[0].size / BytesPerPixel;
+    bool emptyBlue = true;
+    uint64_t nonNormals = 0;
+    for (uint64_t i = 0; i < pixelCount; ++i)
+    {
+        const uint8_t* pixel = pixels + i * BytesPerPixel;
+        if (pixel[3] != 255)
+            return false;
+
+        emptyBlue = emptyBlue && pixel[2] == 0;
+        const int32_t x = 2 * pixel[0] - 255;
+        const int32_t y = 2 * pixel[1] - 255;
+        const int32_t z = 2 * pixel[2] - 255;
+        const int32_t length = x * x + y * y + z * z;
+        if (z < 0 || length < MinLength || length > MaxLength)
+            ++nonNormals;
+    }
+    return emptyBlue || nonNormals <= pixelCount / 100;
+}
+
+std::unique_ptr<Image> Image::Create(uint32_t width, uint32_t height, const uint8_t* pixels)
+{
+    auto image = std::make_unique<Image>();
+    image->mWidth = width;
+    image->mHeight = height;
+    image->mPixels.assign(pixels, pixels + size_t(width) * height * BytesPerPixel);
+    image->mPixelView = image->mPixels;
+    image->mMips.push_back({ width, height, 0, std::size(image->mPixels) });
+    return image;
+}
+
+std::unique_ptr<Image> Image::Load(const std::filesystem::path& filepath, const ImageLoadOptions& options)
+{
+    if (options.useCache)
+    {
+        if (auto cachedImage = TextureCache::Load(filepath, options.compression))
+            return cachedImage;
+    }
+
+    auto image = Decode(filepath);
+    if (!image)
+        return {};
+
+    // Compressed levels can't be blitted on the GPU, so the whole chain is built before encoding.
+    // BC5 holds two channel data like normals that isn't sRGB encoded
+    const VkFormat format = GetCompressedFormat(options.compression, *image);
+    if (options.useCache || options.generateMips || options.compression != TextureCompression::None)
+        image->GenerateMips(format != VK_FORMAT_BC5_UNORM_BLOCK);
+
+    if (options.compression != TextureCompression::None)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        const float uncompressedSize = (float)std::size(image->GetPixels());
+        image->Compress(format);
+        const float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        LOG_INFO("Compressed {0} in {1:.2f} ms ({2:.2f}x)", filepath.string(), seconds * 1000.0f,
+            uncompressedSize / std::size(image->GetPixels()));
+    }
+
+    // The cooked copy is used from here on like on later runs, which frees the decoded pixels
+    if (options.useCache && TextureCache::Write(filepath, *image, options.compression))
+    {
+        if (auto cachedImage = TextureCache::Load(filepath, options.compression))
+            return cachedImage;
+    }
+
+    return image;
+}
+
+uint32_t Image::GetMipCount(uint32_t width, uint32_t height)
+{
+    uint32_t mipCount = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2)
+        ++mipCount;
+    return mipCount;
+}
+
+std::unique_ptr<Image> Image::Decode(const std::filesystem::path& filepath)
+{
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    stbi_uc* pixels = stbi_load(filepath.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+    if (!pixels)
+    {
+        LOG_ERROR("Failed to load image {0}: {1}", filepath.string(), stbi_failure_reason());
+        return {};
+    }
+
+    auto image = Create((uint32_t)width, (uint32_t)height, pixels);
+    stbi_image_free(pixels);
+    return image;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "Span.h"
+#include "MappedFile.h"
+
+// One level of an image's mip chain, the offset is into the image's pixel data
+struct ImageMip
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+};
+
+// Picked per image: whatever is asked for, two channel images like normal maps are stored as BC5
+enum class TextureCompression
+{
+    None,
+    // BC1, or BC3 when the image has any transparency
+    BC1,
+    // BC5 only for two channel images, color images fall back to BC7
+    BC5,
+    BC7
+};
+
+struct ImageLoadOptions
+{
+    bool useCache = true;
+    // Build the mip chain on the CPU even when it isn't cached instead of leaving it to GPU blits
+    bool generateMips = false;
+    TextureCompression compression = TextureCompression::None;
+};
+
+// Decoded image, RGBA8 unless it was block compressed. Loaded on the CPU so it can be done off the render thread
+class Image
+{
+public:
+    Image() = default;
+
+    Image(const Image&) = delete;
+    Image& operator=(const Image&) = delete;
+
+    uint32_t GetWidth() const { return mWidth; }
+    uint32_t GetHeight() const { return mHeight; }
+    VkFormat GetFormat() const { return mFormat; }
+    // Every mip level back to back, largest first
+    Span<const uint8_t> GetPixels() const { return mPixelView; }
+    // Only the full size level unless the mip chain was generated or loaded from the texture cache
+    const std::vector<ImageMip>& GetMips() const { return mMips; }
+
+    // Full chain down to 1x1, each level a 2x2 box filter of the one before. Only for RGBA8 images,
+    // with srgb the color channels are filtered in linear space
+    void GenerateMips(bool srgb = true);
+    // Encodes every level of an RGBA8 image into the given BC format
+    void Compress(VkFormat format);
+    bool HasAlpha() const;
+    // Opaque with an empty blue channel, or nearly every pixel a unit length tangent space normal
+    bool IsTwoChannel() const;
+    // Pixels point into a mapped texture cache, a level is only read from disk once it is touched
+    bool IsMapped() const { return mMappedFile != nullptr; }
+
+    static std::unique_ptr<Image> Create(uint32_t width, uint32_t height, const uint8_t* pixels);
+
+    // With useCache the cooked texture next to the source is used when it is up to date, otherwise the
+    // source is decoded, its mip chain generated and the result cooked for the next load.
+    // Without it only the full size level is decoded, unless generateMips is set or the image is compressed which
+    // needs every level on the CPU.
+    static std::unique_ptr<Image> Load(const std::filesystem::path& filepath, const ImageLoadOptions& options = {});
+
+    static uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+private:
+    static std::unique_ptr<Image> Decode(const std::filesystem::path& filepath);
+
+private:
+    friend class TextureCache;
+
+    uint32_t mWidth = 0;
+    uint32_t mHeight = 0;
+    VkFormat mFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+    std::vector<uint8_t> mPixels;
+    // Points at either mPixels or at the pixels inside a mapped texture cache
+    Span<const uint8_t> mPixelView;
+    std::vector<ImageMip> mMips;
+
+    std::unique_ptr<MappedFile> mMappedFile;
+};
@@ -0,0 +1,300 @@
+#include "Json.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+class JsonParser
+{
+public:
+    JsonParser(std::string_view text) : mText(text) {}
+
+    JsonValue ParseDocument()
+    {
+        JsonValue value = ParseValue(0);
+        SkipWhitespace();
+        if (mPos != std::size(mText))
+            throw std::runtime_error("Unexpected data after JSON value");
+        return value;
+    }
+
+private:
+    // Deeper documents are rejected instead of overflowing the stack
+    static constexpr uint32_t MaxDepth = 256;
+
+    JsonValue ParseValue(uint32_t depth)
+    {
+        if (depth > MaxDepth)
+            throw std::runtime_error("JSON nested too deeply");
+
+        SkipWhitespace();
+        JsonValue value;
+        switch (Peek())
+        {
+        case '{':
+            ParseObject(value, depth);
+            break;
+        case '[':
+            ParseArray(value, depth);
+            break;
+        case '"':
+            value.mType = JsonValue::Type::String;
+            value.mString = ParseString();
+            break;
+        case 't':
+            Expect("true");
+            value.mType = JsonValue::Type::Bool;
+            value.mBool = true;
+            break;
+        case 'f':
+            Expect("false");
+            value.mType = JsonValue::Type::Bool;
+            break;
+        case 'n':
+            Expect("null");
+            break;
+        default:
+            value.mType = JsonValue::Type::Number;
+            value.mNumber = ParseNumber();
+            break;
+        }
+        return value;
+    }
+
+    void ParseObject(JsonValue& value, uint32_t depth)
+    {
+        value.mType = JsonValue::Type::Object;
+        ++mPos;
+        SkipWhitespace();
+        if (Peek() == '}')
+        {
+            ++mPos;
+            return;
+        }
+
+        while (true)
+        {
+            SkipWhitespace();
+            if (Peek() != '"')
+                throw std::runtime_error("Expected a JSON object key");
+            value.mKeys.push_back(ParseString());
+
+            SkipWhitespace();
+            if (Next() != ':')
+                throw std::runtime_error("Expected ':' after JSON object key");
+            value.mValues.push_back(ParseValue(depth + 1));
+
+            SkipWhitespace();
+            const char c = Next();
+            if (c == '}')
+                return;
+            if (c != ',')
+                throw std::runtime_error("Expected ',' or '}' in JSON object");
+        }
+    }
+
+    void ParseArray(JsonValue& value, uint32_t depth)
+    {
+        value.mType = JsonValue::Type::Array;
+        ++mPos;
+        SkipWhitespace();
+        if (Peek() == ']')
+        {
+            ++mPos;
+            return;
+        }
+
+        while (true)
+        {
+            value.mValues.push_back(ParseValue(depth + 1));
+
+            SkipWhitespace();
+            const char c = Next();
+            if (c == ']')
+                return;
+            if (c != ',')
+                throw std::runtime_error("Expected ',' or ']' in JSON array");
+        }
+    }
+
+    std::string ParseString()
+    {
+        ++mPos;
+        std::string str;
+        while (true)
+        {
+            const char c = Next();
+            if (c == '"')
+                return str;
+            if ((unsigned char)c < 0x20)
+                throw std::runtime_error("Control character in JSON string");
+            if (c != '\\')
+            {
+                str += c;
+                continue;
+            }
+
+            const char escape = Next();
+            switch (escape)
+            {
+            case '"': str += '"'; break;
+            case '\\': str += '\\'; break;
+            case '/': str += '/'; break;
+            case 'b': str += '\b'; break;
+            case 'f': str += '\f'; break;
+            case 'n': str += '\n'; break;
+            case 'r': str += '\r'; break;
+            case 't': str += '\t'; break;
+            case 'u': AppendCodePoint(str, ParseUnicodeEscape()); break;
+            default:
+                throw std::runtime_error("Invalid JSON escape sequence");
+            }
+        }
+    }
+
+    uint32_t ParseUnicodeEscape()
+    {
+        uint32_t codePoint = ParseHex4();
+        if (codePoint >= 0xd800 && codePoint < 0xdc00)
+        {
+            // High surrogate, the low half has to follow as another escape
+            if (Next() != '\\' || Next() != 'u')
+                throw std::runtime_error("Unpaired surrogate in JSON string");
+            const uint32_t low = ParseHex4();
+            if (low < 0xdc00 || low >= 0xe000)
+                throw std::runtime_error("Invalid surrogate pair in JSON string");
+            codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+        }
+        return codePoint;
+    }
+
+    uint32_t ParseHex4()
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            const char c = Next();
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= uint32_t(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                value |= uint32_t(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F')
+                value |= uint32_t(c - 'A' + 10);
+            else
+                throw std::runtime_error("Invalid JSON unicode escape");
+        }
+        return value;
+    }
+
+    static void AppendCodePoint(std::string& str, uint32_t codePoint)
+    {
+        if (codePoint < 0x80)
+            str += (char)codePoint;
+        else if (codePoint < 0x800)
+        {
+            str += char(0xc0 | (codePoint >> 6));
+            str += char(0x80 | (codePoint & 0x3f));
+        }
+        else if (codePoint < 0x10000)
+        {
+            str += char(0xe0 | (codePoint >> 12));
+            str += char(0x80 | ((codePoint >> 6) & 0x3f));
+            str += char(0x80 | (codePoint & 0x3f));
+        }
+        else
+        {
+            str += char(0xf0 | (codePoint >> 18));
+            str += char(0x80 | ((codePoint >> 12) & 0x3f));
+            str += char(0x80 | ((codePoint >> 6) & 0x3f));
+            str += char(0x80 | (codePoint & 0x3f));
+        }
+    }
+
+    double ParseNumber()
+    {
+        const size_t start = mPos;
+        if (Peek() == '-')
+            ++mPos;
+        while (mPos < std::size(mText) && IsNumberChar(mText[mPos]))
+            ++mPos;
+
+        // strtod needs a terminated string, numbers are short so the copy is cheap
+        const std::string number(mText.substr(start, mPos - start));
+        char* end = nullptr;
+        const double value = std::strtod(number.c_str(), &end);
+        if (std::empty(number) || end != number.c_str() + std::size(number) || !std::isfinite(value))
+            throw std::runtime_error("Invalid JSON number");
+        return value;
+    }
+
+    static bool IsNumberChar(char c)
+    {
+        return (c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-';
+    }
+
+    void Expect(std::string_view literal)
+    {
+        if (mText.substr(mPos, std::size(literal)) != literal)
+            throw std::runtime_error("Invalid JSON literal");
+        mPos += std::size(literal);
+    }
+
+    void SkipWhitespace()
+    {
+        while (mPos < std::size(mText) && (mText[mPos] == ' ' || mText[mPos] == '\t' || mText[mPos] == '\n' || mText[mPos] == '\r'))
+            ++mPos;
+    }
+
+    char Peek() const
+    {
+        if (mPos >= std::size(mText))
+            throw std::runtime_error("Unexpected end of JSON");
+        return mText[mPos];
+    }
+
+    char Next()
+    {
+        const char c = Peek();
+        ++mPos;
+        return c;
+    }
+
+private:
+    std::string_view mText;
+    size_t mPos = 0;
+};
+
+uint32_t JsonValue::GetUint(uint32_t defaultValue) const
+{
+    if (mType != Type::Number || mNumber < 0.0 || mNumber > 4294967295.0 || mNumber != std::floor(mNumber))
+        return defaultValue;
+    return (uint32_t)mNumber;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    static const JsonValue null;
+    if (mType != Type::Array || index >= std::size(mValues))
+        return null;
+    return mValues[index];
+}
+
+const JsonValue& JsonValue::operator[](std::string_view key) const
+{
+    static const JsonValue null;
+    if (mType != Type::Object)
+        return null;
+
+    for (size_t i = 0; i < std::size(mKeys); ++i)
+    {
+        if (mKeys[i] == key)
+            return mValues[i];
+    }
+    return null;
+}
+
+JsonValue JsonValue::Parse(std::string_view text)
+{
+    return JsonParser(text).ParseDocument();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Minimal JSON document, enough to read glTF. Parse throws std::runtime_error on malformed input.
+class JsonValue
+{
+public:
+    enum class Type
+    {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    JsonValue() = default;
+
+    Type GetType() const { return mType; }
+    bool IsNull() const { return mType == Type::Null; }
+    bool IsNumber() const { return mType == Type::Number; }
+    bool IsString() const { return mType == Type::String; }
+    bool IsArray() const { return mType == Type::Array; }
+    bool IsObject() const { return mType == Type::Object; }
+
+    // The defaults are returned when the value has a different type, so missing optional members read as their default
+    bool GetBool(bool defaultValue = false) const { return mType == Type::Bool ? mBool : defaultValue; }
+    double GetNumber(double defaultValue = 0.0) const { return mType == Type::Number ? mNumber : defaultValue; }
+    uint32_t GetUint(uint32_t defaultValue = 0) const;
+    const std::string& GetString() const { return mString; }
+
+    // Element count of an array or member count of an object
+    size_t GetSize() const { return std::size(mValues); }
+    const std::vector<JsonValue>& GetElements() const { return mValues; }
+    const std::vector<std::string>& GetKeys() const { return mKeys; }
+
+    // A null value when the index or key doesn't exist
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](std::string_view key) const;
+    bool HasMember(std::string_view key) const { return !(*this)[key].IsNull(); }
+
+    static JsonValue Parse(std::string_view text);
+
+private:
+    friend class JsonParser;
+
+    Type mType = Type::Null;
+    bool mBool = false;
+    double mNumber = 0.0;
+    std::string mString;
+
+    // Array elements, or object members with their keys at the same index
+    std::vector<JsonValue> mValues;
+    std::vector<std::string> mKeys;
+};
@@ -0,0 +1,77 @@
+#include "MappedFile.h"
+
+#ifdef PLATFORM_WINDOWS
+#   define WIN32_LEAN_AND_MEAN
+#   define NOMINMAX
+#   include <Windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+#ifdef PLATFORM_WINDOWS
+    if (mData)
+        UnmapViewOfFile(mData);
+    if (mMappingHandle)
+        CloseHandle(mMappingHandle);
+    if (mFileHandle)
+        CloseHandle(mFileHandle);
+#else
+    if (mData)
+        munmap((void*)mData, mSize);
+#endif
+}
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& filepath)
+{
+    auto file = std::make_unique<MappedFile>();
+
+#ifdef PLATFORM_WINDOWS
+    HANDLE fileHandle = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+        return {};
+    file->mFileHandle = fileHandle;
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+        return {};
+
+    HANDLE mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle)
+        return {};
+    file->mMappingHandle = mappingHandle;
+
+    const void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+        return {};
+
+    file->mData = (const uint8_t*)data;
+    file->mSize = (size_t)fileSize.QuadPart;
+#else
+    const int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return {};
+
+    struct stat fileStat{};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(fd);
+        return {};
+    }
+
+    void* data = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return {};
+
+    file->mData = (const uint8_t*)data;
+    file->mSize = (size_t)fileStat.st_size;
+#endif
+
+    return file;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+#include <cstdint>
+
+#include "Span.h"
+
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* GetData() const { return mData; }
+    size_t GetSize() const { return mSize; }
+    Span<const uint8_t> GetBytes() const { return { mData, mSize }; }
+
+    static std::unique_ptr<MappedFile> Open(const std::filesystem::path& filepath);
+
+private:
+    const uint8_t* mData = nullptr;
+    size_t mSize = 0;
+
+#ifdef PLATFORM_WINDOWS
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct Material
+{
+    static constexpr uint32_t NoTexture = ~0u;
+
+    std::string name;
+    // Index into the model's texture paths, materials using the same file share the index
+    uint32_t diffuseTexture = NoTexture;
+};
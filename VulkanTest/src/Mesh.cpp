@@ -2,41 +2,230 @@
 
 #include <assimp/mesh.h>
 
+#include <limits>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+
+#include "Log.h"
+#include "MeshOptimizer.h"
+#include "VertexUtils.h"
+#include "Vulkan/VulkanUtils.h"
+
 std::unique_ptr<Mesh> Mesh::Load(const aiMesh* const mesh)
 {
     auto loadedMesh = std::make_unique<Mesh>();
     loadedMesh->mName = mesh->mName.C_Str();
+    loadedMesh->mMaterialIndex = mesh->mMaterialIndex;
 
-    for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
-    {
-        const aiVector3D pos = mesh->mVertices[i];
-
-        aiVector3D normal(0.0f, 0.0f, 0.0f);
-        if (mesh->HasNormals())
-            normal = mesh->mNormals[i];
-
-        aiColor4D color(1.0f, 1.0f, 1.0f, 1.0f);
-        if (mesh->HasVertexColors(0))
-            color = mesh->mColors[0][i];
-
-        aiVector3D texCoord(0.0f, 0.0f, 0.0f);
-        if (mesh->HasTextureCoords(0))
-            texCoord = mesh->mTextureCoords[0][i];
-
-        Vertex vert;
-        vert.pos = { pos.x, pos.y, pos.z };
-        vert.normal = { normal.x, normal.y, normal.z };
-        vert.color = { color.r, color.g, color.b };
-        vert.texCoord = { texCoord.x, texCoord.y };
-        loadedMesh->mVertices.push_back(vert);
-    }
+    static_assert(sizeof(aiVector3D) == 3 * sizeof(float) && sizeof(aiColor4D) == 4 * sizeof(float),
+        "VertexUtils::ConvertVertices expects float Assimp vectors");
+
+    // The attribute layout is resolved once and the arrays are converted in bulk
+    loadedMesh->mVertices.resize(mesh->mNumVertices);
+    const auto convertStart = std::chrono::steady_clock::now();
+    VertexUtils::ConvertVertices(std::data(loadedMesh->mVertices), mesh->mNumVertices,
+        (const float*)mesh->mVertices,
+        mesh->HasNormals() ? (const float*)mesh->mNormals : nullptr,
+        mesh->HasVertexColors(0) ? (const float*)mesh->mColors[0] : nullptr,
+        mesh->HasTextureCoords(0) ? (const float*)mesh->mTextureCoords[0] : nullptr);
+    const float convertSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - convertStart).count();
+    const size_t convertedSize = size_t(mesh->mNumVertices) * sizeof(Vertex);
+    LOG_TRACE("Converted {0} vertices of {1} in {2:.3f} ms ({3:.2f} GB/s)", mesh->mNumVertices, loadedMesh->mName,
+        convertSeconds * 1e3f, convertSeconds > 0.0f ? convertedSize / 1e9 / convertSeconds : 0.0);
 
+    std::vector<uint32_t> indices;
+    indices.reserve(size_t(mesh->mNumFaces) * 3);
     for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
     {
+        // Points and lines can't be drawn as part of a triangle list
         const aiFace& face = mesh->mFaces[i];
+        if (face.mNumIndices != 3)
+            continue;
+
         for (uint32_t faceI = 0; faceI < face.mNumIndices; ++faceI)
-            loadedMesh->mIndices.push_back(face.mIndices[faceI]);
+            indices.push_back(face.mIndices[faceI]);
     }
 
+    loadedMesh->mVertexView = loadedMesh->mVertices;
+    loadedMesh->mBounds = VertexUtils::ComputeBounds(loadedMesh->mVertexView);
+    loadedMesh->SetIndices(indices);
+
     return loadedMesh;
 }
+
+VkIndexType Mesh::ChooseIndexType(size_t vertexCount)
+{
+    if (vertexCount <= size_t(std::numeric_limits<uint16_t>::max()) + 1)
+        return VK_INDEX_TYPE_UINT16;
+
+    return VK_INDEX_TYPE_UINT32;
+}
+
+void Mesh::SetVertices(std::vector<Vertex>&& vertices)
+{
+    mVertices = std::move(vertices);
+    mVertexView = mVertices;
+    mBounds = VertexUtils::ComputeBounds(mVertexView);
+}
+
+void Mesh::SetIndices(const std::vector<uint32_t>& indices)
+{
+    mIndexType = ChooseIndexType(std::size(mVertexView));
+    mIndexCount = (uint32_t)std::size(indices);
+    mIndices.resize(std::size(indices) * vk::utils::GetIndexSize(mIndexType));
+
+    if (mIndexType == VK_INDEX_TYPE_UINT16)
+    {
+        uint16_t* dst = (uint16_t*)std::data(mIndices);
+        for (size_t i = 0; i < std::size(indices); ++i)
+            dst[i] = (uint16_t)indices[i];
+    }
+    else
+    {
+        memcpy(std::data(mIndices), std::data(indices), std::size(mIndices));
+    }
+
+    mIndexView = mIndices;
+}
+
+std::vector<uint32_t> Mesh::CopyIndices() const
+{
+    std::vector<uint32_t> indices(mIndexCount);
+    if (mIndexType == VK_INDEX_TYPE_UINT16)
+    {
+        const uint16_t* src = (const uint16_t*)std::data(mIndexView);
+        for (size_t i = 0; i < std::size(indices); ++i)
+            indices[i] = src[i];
+    }
+    else
+    {
+        memcpy(std::data(indices), std::data(mIndexView), std::size(indices) * sizeof(uint32_t));
+    }
+
+    return indices;
+}
+
+void Mesh::WeldVertices(float epsilon)
+{
+    auto indices = CopyIndices();
+    auto vertices = MeshOptimizer::WeldVertices(indices, mVertexView, epsilon);
+
+    LOG_INFO("Welded {0}: {1} -> {2} vertices", mName, std::size(mVertexView), std::size(vertices));
+
+    SetVertices(std::move(vertices));
+    SetIndices(indices);
+}
+
+void Mesh::OptimizeVertexCache()
+{
+    auto indices = CopyIndices();
+    const size_t vertexCount = std::size(mVertexView);
+
+    const auto before = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+    MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+    const auto after = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+
+    LOG_INFO("Vertex cache optimized {0}: ACMR {1:.3f} -> {2:.3f}, ATVR {3:.3f} -> {4:.3f}",
+        mName, before.acmr, after.acmr, before.atvr, after.atvr);
+
+    SetIndices(indices);
+}
+
+void Mesh::OptimizeOverdraw(float threshold)
+{
+    auto indices = CopyIndices();
+    const size_t vertexCount = std::size(mVertexView);
+
+    const auto cacheBefore = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+    const auto overdrawBefore = MeshOptimizer::AnalyzeOverdraw(indices, mVertexView);
+    MeshOptimizer::OptimizeOverdraw(indices, mVertexView, threshold);
+    const auto cacheAfter = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+    const auto overdrawAfter = MeshOptimizer::AnalyzeOverdraw(indices, mVertexView);
+
+    LOG_INFO("Overdraw optimized {0}: overdraw {1:.3f} -> {2:.3f}, ACMR {3:.3f} -> {4:.3f}",
+        mName, overdrawBefore.overdraw, overdrawAfter.overdraw, cacheBefore.acmr, cacheAfter.acmr);
+
+    SetIndices(indices);
+}
+
+void Mesh::OptimizeVertexFetch()
+{
+    auto indices = CopyIndices();
+
+    const auto before = MeshOptimizer::AnalyzeVertexFetch(indices, std::size(mVertexView), sizeof(Vertex));
+    auto vertices = MeshOptimizer::OptimizeVertexFetch(indices, mVertexView);
+    const auto after = MeshOptimizer::AnalyzeVertexFetch(indices, std::size(vertices), sizeof(Vertex));
+
+    LOG_INFO("Vertex fetch optimized {0}: overfetch {1:.3f} -> {2:.3f}, {3} -> {4} vertices",
+        mName, before.overfetch, after.overfetch, std::size(mVertexView), std::size(vertices));
+
+    SetVertices(std::move(vertices));
+    SetIndices(indices);
+}
+
+void Mesh::BuildMeshlets()
+{
+    auto data = MeshOptimizer::BuildMeshlets(CopyIndices(), mVertexView);
+
+    mMeshlets = std::move(data.meshlets);
+    mMeshletVertices = std::move(data.vertices);
+    mMeshletTriangles = std::move(data.triangles);
+    mMeshletView = mMeshlets;
+    mMeshletVertexView = mMeshletVertices;
+    mMeshletTriangleView = mMeshletTriangles;
+
+    const size_t triangleCount = mIndexCount / 3;
+    LOG_INFO("Built {0} meshlets for {1}: {2:.1f} vertices, {3:.1f} triangles per meshlet",
+        std::size(mMeshlets), mName,
+        std::empty(mMeshlets) ? 0.0 : double(std::size(mMeshletVertices)) / std::size(mMeshlets),
+        std::empty(mMeshlets) ? 0.0 : double(triangleCount) / std::size(mMeshlets));
+}
+
+void Mesh::BuildLods(uint32_t lodCount, float lodRatio)
+{
+    const auto indices = CopyIndices();
+    const size_t vertexCount = std::size(mVertexView);
+
+    std::vector<uint32_t> allIndices = indices;
+    mLods.clear();
+    mLods.push_back({ 0, mIndexCount, 0.0f });
+
+    size_t targetIndexCount = std::size(indices);
+    for (uint32_t level = 1; level < lodCount; ++level)
+    {
+        targetIndexCount = size_t(targetIndexCount * lodRatio) / 3 * 3;
+
+        float error = 0.0f;
+        auto lod = MeshOptimizer::Simplify(indices, mVertexView, targetIndexCount, error);
+
+        // Stop once the simplifier can't make meaningful progress
+        if (std::empty(lod) || std::size(lod) > mLods.back().indexCount * 0.95f)
+            break;
+
+        MeshOptimizer::OptimizeVertexCache(lod, vertexCount);
+
+        MeshLod meshLod;
+        meshLod.firstIndex = (uint32_t)std::size(allIndices);
+        meshLod.indexCount = (uint32_t)std::size(lod);
+        meshLod.error = std::max(error, mLods.back().error);
+        mLods.push_back(meshLod);
+
+        allIndices.insert(std::end(allIndices), std::begin(lod), std::end(lod));
+
+        LOG_INFO("Built LOD {0} for {1}: {2} triangles, error {3}", level, mName, std::size(lod) / 3, meshLod.error);
+    }
+
+    SetIndices(allIndices);
+    mIndexCount = (uint32_t)std::size(indices);
+    mLodView = mLods;
+}
+
+uint32_t Mesh::SelectLod(float maxError) const
+{
+    uint32_t lod = 0;
+    while (lod + 1 < std::size(mLodView) && mLodView[lod + 1].error <= maxError)
+        ++lod;
+
+    return lod;
+}
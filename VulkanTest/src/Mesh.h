@@ -5,26 +5,92 @@
 #include <memory>
 
 #include "Vertex.h"
+#include "Span.h"
+#include "Meshlet.h"
+#include "Bounds.h"
 
 struct aiMesh;
 
+// A level of detail stored after the full detail indices in the mesh's index data
+struct MeshLod
+{
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    // Largest geometric deviation from the full detail mesh, in model units
+    float error = 0.0f;
+};
+
 class Mesh
 {
 public:
     Mesh() = default;
 
     const std::string& GetName() const { return mName; }
-    const std::vector<Vertex>& GetVertices() const { return mVertices; }
-    const std::vector<uint16_t>& GetIndices() const { return mIndices; }
+    Span<const Vertex> GetVertices() const { return mVertexView; }
+
+    // Raw index data, either 16 or 32 bits per index depending on the vertex count.
+    // Holds the full detail indices followed by any LODs.
+    Span<const uint8_t> GetIndexData() const { return mIndexView; }
+    VkIndexType GetIndexType() const { return mIndexType; }
+    // Index count of the full detail mesh
+    uint32_t GetIndexCount() const { return mIndexCount; }
+    std::vector<uint32_t> CopyIndices() const;
+
+    // LOD 0 is the full detail mesh, empty unless BuildLods was run
+    Span<const MeshLod> GetLods() const { return mLodView; }
+    // Coarsest LOD whose error is within maxError
+    uint32_t SelectLod(float maxError) const;
+
+    // Empty unless BuildMeshlets was run
+    Span<const Meshlet> GetMeshlets() const { return mMeshletView; }
+    Span<const uint32_t> GetMeshletVertices() const { return mMeshletVertexView; }
+    Span<const uint8_t> GetMeshletTriangles() const { return mMeshletTriangleView; }
+
+    const Bounds& GetBounds() const { return mBounds; }
+
+    // Index into the owning model's materials
+    uint32_t GetMaterialIndex() const { return mMaterialIndex; }
 
-    const std::string& GetDiffuseTextureName() const { return mDiffuseTextureName; }
+    void WeldVertices(float epsilon);
+    void OptimizeVertexCache();
+    void OptimizeOverdraw(float threshold);
+    void OptimizeVertexFetch();
+    void BuildMeshlets();
+    void BuildLods(uint32_t lodCount, float lodRatio);
 
     static std::unique_ptr<Mesh> Load(const aiMesh* const mesh);
 
+    static VkIndexType ChooseIndexType(size_t vertexCount);
+
+private:
+    void SetVertices(std::vector<Vertex>&& vertices);
+    void SetIndices(const std::vector<uint32_t>& indices);
+
 private:
+    friend class MeshCache;
+    friend class GltfLoader;
+
     std::string mName;
     std::vector<Vertex> mVertices;
-    std::vector<uint16_t> mIndices;
+    std::vector<uint8_t> mIndices;
+    VkIndexType mIndexType = VK_INDEX_TYPE_UINT16;
+    uint32_t mIndexCount = 0;
+
+    // Point at either the vectors above or at data inside a mapped mesh cache
+    Span<const Vertex> mVertexView;
+    Span<const uint8_t> mIndexView;
+
+    std::vector<MeshLod> mLods;
+    Span<const MeshLod> mLodView;
+
+    std::vector<Meshlet> mMeshlets;
+    std::vector<uint32_t> mMeshletVertices;
+    std::vector<uint8_t> mMeshletTriangles;
+    Span<const Meshlet> mMeshletView;
+    Span<const uint32_t> mMeshletVertexView;
+    Span<const uint8_t> mMeshletTriangleView;
+
+    Bounds mBounds;
 
-    std::string mDiffuseTextureName;
+    uint32_t mMaterialIndex = 0;
 };
@@ -0,0 +1,404 @@
+#include "MeshCache.h"
+
+#include "Model.h"
+#include "MappedFile.h"
+#include "BinaryIO.h"
+#include "FileUtils.h"
+#include "MeshCodec.h"
+#include "ThreadPool.h"
+#include "Log.h"
+#include "Vulkan/VulkanUtils.h"
+
+#include <fstream>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t CacheMagic = 0x4843544d; // "MTCH"
+    constexpr uint32_t CacheVersion = 9;
+    constexpr size_t DataAlignment = 16;
+
+    // Vertex and index data is stored through MeshCodec instead of as is
+    constexpr uint32_t CacheFlagCompressed = 1 << 0;
+
+    struct CacheHeader
+    {
+        uint32_t magic = CacheMagic;
+        uint32_t version = CacheVersion;
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        uint64_t sourceHash = 0;
+        uint64_t processingHash = 0;
+        uint32_t meshCount = 0;
+        uint32_t flags = 0;
+    };
+
+    // Compressed mesh data still to be decoded into the mesh's own vectors
+    struct PendingDecode
+    {
+        Mesh* mesh = nullptr;
+        size_t vertexCount = 0;
+        size_t indexDataCount = 0;
+        Span<const uint8_t> vertices;
+        Span<const uint8_t> indices;
+    };
+
+    // Decodes the meshes again runs times into scratch vectors allocated up front, so only the codec is timed
+    void BenchmarkDecode(const std::vector<PendingDecode>& pendingDecodes, uint32_t runs)
+    {
+        size_t compressedSize = 0;
+        size_t decodedSize = 0;
+        std::vector<std::vector<Vertex>> vertices(std::size(pendingDecodes));
+        std::vector<std::vector<uint8_t>> indices(std::size(pendingDecodes));
+        for (size_t i = 0; i < std::size(pendingDecodes); ++i)
+        {
+            const auto& decode = pendingDecodes[i];
+            vertices[i].resize(decode.vertexCount);
+            indices[i].resize(decode.indexDataCount * vk::utils::GetIndexSize(decode.mesh->GetIndexType()));
+            compressedSize += std::size(decode.vertices) + std::size(decode.indices);
+            decodedSize += vertices[i].size() * sizeof(Vertex) + std::size(indices[i]);
+        }
+
+        float bestSeconds = std::numeric_limits<float>::max();
+        float totalSeconds = 0.0f;
+        for (uint32_t run = 0; run < runs; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            ThreadPool::Get().ParallelFor(std::size(pendingDecodes), [&](size_t i) {
+                const auto& decode = pendingDecodes[i];
+                MeshCodec::DecodeVertices(decode.vertices, std::data(vertices[i]), decode.vertexCount);
+                MeshCodec::DecodeIndices(decode.indices, std::data(indices[i]), decode.indexDataCount, decode.mesh->GetIndexType());
+            });
+            const float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+            bestSeconds = std::min(bestSeconds, seconds);
+            totalSeconds += seconds;
+        }
+
+        const float meanSeconds = totalSeconds / runs;
+        LOG_INFO("Decode benchmark: {0:.1f} MB from {1:.1f} MB ({2:.2f}x) on {3} pool threads, {4} runs, best {5:.2f} ms ({6:.2f} GB/s), mean {7:.2f} ms ({8:.2f} GB/s)",
+            decodedSize / 1e6, compressedSize / 1e6, compressedSize > 0 ? double(decodedSize) / compressedSize : 0.0,
+            ThreadPool::Get().GetThreadCount(), runs,
+            bestSeconds * 1e3f, bestSeconds > 0.0f ? decodedSize / 1e9 / bestSeconds : 0.0,
+            meanSeconds * 1e3f, meanSeconds > 0.0f ? decodedSize / 1e9 / meanSeconds : 0.0);
+    }
+}
+
+std::filesystem::path MeshCache::GetCachePath(const std::filesystem::path& sourcePath)
+{
+    auto cachePath = sourcePath;
+    cachePath += ".meshcache";
+    return cachePath;
+}
+
+std::unique_ptr<Model> MeshCache::Load(const std::filesystem::path& sourcePath, const ModelLoadOptions& options)
+{
+    const auto cachePath = GetCachePath(sourcePath);
+    auto cacheFile = MappedFile::Open(cachePath);
+    if (!cacheFile)
+        return {};
+
+    try
+    {
+        BinaryReader reader(cacheFile->GetBytes());
+
+        const auto header = reader.Read<CacheHeader>();
+        if (header.magic != CacheMagic || header.version != CacheVersion)
+        {
+            LOG_INFO("Mesh cache {0} has an unsupported version, rebuilding", cachePath.string());
+            return {};
+        }
+
+        if (header.processingHash != options.GetProcessingHash())
+        {
+            LOG_INFO("Mesh cache {0} was built with different load options, rebuilding", cachePath.string());
+            return {};
+        }
+
+        if (((header.flags & CacheFlagCompressed) != 0) != options.compressCache)
+        {
+            LOG_INFO("Mesh cache {0} was built with a different compression mode, rebuilding", cachePath.string());
+            return {};
+        }
+
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        if (!FileUtils::GetFileStats(sourcePath, sourceSize, sourceWriteTime) ||
+            sourceSize != header.sourceSize || sourceWriteTime != header.sourceWriteTime)
+        {
+            LOG_INFO("Mesh cache {0} is out of date, rebuilding", cachePath.string());
+            return {};
+        }
+
+        uint64_t sourceHash = 0;
+        if (!FileUtils::HashFile(sourcePath, sourceHash) || sourceHash != header.sourceHash)
+        {
+            LOG_INFO("Mesh cache {0} does not match source contents, rebuilding", cachePath.string());
+            return {};
+        }
+
+        auto model = std::make_unique<Model>();
+        model->mName = reader.ReadString();
+        model->mBounds = reader.Read<Bounds>();
+
+        model->mTexturePaths.resize(reader.Read<uint32_t>());
+        for (auto& texturePath : model->mTexturePaths)
+            texturePath = reader.ReadString();
+
+        model->mMaterials.resize(reader.Read<uint32_t>());
+        for (auto& material : model->mMaterials)
+        {
+            material.name = reader.ReadString();
+            material.diffuseTexture = reader.Read<uint32_t>();
+            if (material.diffuseTexture != Material::NoTexture && material.diffuseTexture >= std::size(model->mTexturePaths))
+                throw std::runtime_error("Invalid texture index");
+        }
+
+        // AddNode rejects a parent that comes after its child
+        const auto nodeCount = reader.Read<uint32_t>();
+        const auto parents = reader.ReadArray<uint32_t>(nodeCount);
+        const auto localTransforms = reader.ReadArray<glm::mat4>(nodeCount, DataAlignment);
+        for (uint32_t i = 0; i < nodeCount; ++i)
+            model->mNodes.AddNode(parents[i], localTransforms[i]);
+
+        const auto instances = reader.ReadArray<MeshInstance>(reader.Read<uint32_t>());
+        for (const auto& instance : instances)
+        {
+            if (instance.meshIndex >= header.meshCount || instance.nodeIndex >= nodeCount)
+                throw std::runtime_error("Invalid mesh instance");
+        }
+        model->mInstances.assign(std::begin(instances), std::end(instances));
+
+        const bool compressed = (header.flags & CacheFlagCompressed) != 0;
+        std::vector<PendingDecode> pendingDecodes;
+
+        model->mMeshs.reserve(header.meshCount);
+        for (uint32_t i = 0; i < header.meshCount; ++i)
+        {
+            auto mesh = std::make_unique<Mesh>();
+            mesh->mName = reader.ReadString();
+            mesh->mMaterialIndex = reader.Read<uint32_t>();
+            if (!std::empty(model->mMaterials) && mesh->mMaterialIndex >= std::size(model->mMaterials))
+                throw std::runtime_error("Invalid material index");
+            mesh->mBounds = reader.Read<Bounds>();
+
+            const auto vertexCount = reader.Read<uint32_t>();
+            mesh->mIndexCount = reader.Read<uint32_t>();
+            const auto indexDataCount = reader.Read<uint32_t>();
+            if (indexDataCount < mesh->mIndexCount)
+                throw std::runtime_error("Invalid index count");
+            mesh->mIndexType = (VkIndexType)reader.Read<uint32_t>();
+            if (mesh->mIndexType != Mesh::ChooseIndexType(vertexCount))
+                throw std::runtime_error("Invalid index type");
+
+            if (compressed)
+            {
+                PendingDecode decode;
+                decode.mesh = mesh.get();
+                decode.vertexCount = vertexCount;
+                decode.indexDataCount = indexDataCount;
+                const auto vertexSize = reader.Read<uint32_t>();
+                const auto indexSize = reader.Read<uint32_t>();
+                decode.vertices = reader.ReadArray<uint8_t>(vertexSize);
+                decode.indices = reader.ReadArray<uint8_t>(indexSize);
+                pendingDecodes.push_back(decode);
+            }
+            else
+            {
+                const size_t indexDataSize = size_t(indexDataCount) * vk::utils::GetIndexSize(mesh->mIndexType);
+                mesh->mVertexView = reader.ReadArray<Vertex>(vertexCount, DataAlignment);
+                mesh->mIndexView = reader.ReadArray<uint8_t>(indexDataSize, DataAlignment);
+            }
+
+            const auto lodCount = reader.Read<uint32_t>();
+            mesh->mLodView = reader.ReadArray<MeshLod>(lodCount, DataAlignment);
+            for (const auto& lod : mesh->mLodView)
+            {
+                if (size_t(lod.firstIndex) + lod.indexCount > indexDataCount)
+                    throw std::runtime_error("Invalid LOD range");
+            }
+
+            const auto meshletCount = reader.Read<uint32_t>();
+            const auto meshletVertexCount = reader.Read<uint32_t>();
+            const auto meshletTriangleSize = reader.Read<uint32_t>();
+            mesh->mMeshletView = reader.ReadArray<Meshlet>(meshletCount, DataAlignment);
+            mesh->mMeshletVertexView = reader.ReadArray<uint32_t>(meshletVertexCount, DataAlignment);
+            mesh->mMeshletTriangleView = reader.ReadArray<uint8_t>(meshletTriangleSize, DataAlignment);
+
+            model->mMeshs.emplace_back(std::move(mesh));
+        }
+
+        if (!std::empty(pendingDecodes))
+        {
+            // Each mesh decodes into its own vectors, so meshes are decoded in parallel
+            const auto start = std::chrono::steady_clock::now();
+            ThreadPool::Get().ParallelFor(std::size(pendingDecodes), [&](size_t i) {
+                const auto& decode = pendingDecodes[i];
+                auto& mesh = *decode.mesh;
+
+                mesh.mVertices.resize(decode.vertexCount);
+                MeshCodec::DecodeVertices(decode.vertices, std::data(mesh.mVertices), decode.vertexCount);
+                mesh.mVertexView = mesh.mVertices;
+
+                mesh.mIndices.resize(decode.indexDataCount * vk::utils::GetIndexSize(mesh.mIndexType));
+                MeshCodec::DecodeIndices(decode.indices, std::data(mesh.mIndices), decode.indexDataCount, mesh.mIndexType);
+                mesh.mIndexView = mesh.mIndices;
+            });
+            const float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+            size_t decodedSize = 0;
+            for (const auto& decode : pendingDecodes)
+                decodedSize += decode.mesh->mVertexView.size_bytes() + decode.mesh->mIndexView.size_bytes();
+            LOG_INFO("Decoded {0:.1f} MB of mesh data in {1:.2f} ms ({2:.2f} GB/s)",
+                decodedSize / 1e6, seconds * 1e3f, seconds > 0.0f ? decodedSize / 1e9 / seconds : 0.0);
+
+            if (options.decodeBenchRuns > 0)
+                BenchmarkDecode(pendingDecodes, options.decodeBenchRuns);
+        }
+
+        model->mMappedFile = std::move(cacheFile);
+
+        LOG_INFO("Loaded mesh cache {0}", cachePath.string());
+        return model;
+    }
+    catch (const std::exception& e)
+    {
+        LOG_WARN("Failed to read mesh cache {0}: {1}", cachePath.string(), e.what());
+        return {};
+    }
+}
+
+bool MeshCache::Write(const std::filesystem::path& sourcePath, const ModelLoadOptions& options, const Model& model)
+{
+    const auto cachePath = GetCachePath(sourcePath);
+
+    CacheHeader header;
+    header.processingHash = options.GetProcessingHash();
+    header.meshCount = (uint32_t)std::size(model.mMeshs);
+    header.flags = options.compressCache ? CacheFlagCompressed : 0;
+    if (!FileUtils::GetFileStats(sourcePath, header.sourceSize, header.sourceWriteTime) ||
+        !FileUtils::HashFile(sourcePath, header.sourceHash))
+    {
+        LOG_WARN("Failed to fingerprint {0}, not writing mesh cache", sourcePath.string());
+        return false;
+    }
+
+    // Encoding is much slower than decoding, meshes are encoded in parallel up front
+    std::vector<std::vector<uint8_t>> encodedVertices;
+    std::vector<std::vector<uint8_t>> encodedIndices;
+    size_t rawSize = 0;
+    size_t encodedSize = 0;
+    if (options.compressCache)
+    {
+        encodedVertices.resize(std::size(model.mMeshs));
+        encodedIndices.resize(std::size(model.mMeshs));
+        ThreadPool::Get().ParallelFor(std::size(model.mMeshs), [&](size_t i) {
+            const auto& mesh = *model.mMeshs[i];
+            encodedVertices[i] = MeshCodec::EncodeVertices(mesh.GetVertices());
+            encodedIndices[i] = MeshCodec::EncodeIndices(mesh.GetIndexData(), mesh.GetIndexType());
+        });
+
+        for (size_t i = 0; i < std::size(model.mMeshs); ++i)
+        {
+            rawSize += model.mMeshs[i]->GetVertices().size_bytes() + model.mMeshs[i]->GetIndexData().size_bytes();
+            encodedSize += std::size(encodedVertices[i]) + std::size(encodedIndices[i]);
+        }
+    }
+
+    BinaryWriter writer;
+    writer.Write(header);
+    writer.WriteString(model.mName);
+    writer.Write(model.mBounds);
+
+    writer.Write((uint32_t)std::size(model.mTexturePaths));
+    for (const auto& texturePath : model.mTexturePaths)
+        writer.WriteString(texturePath);
+
+    writer.Write((uint32_t)std::size(model.mMaterials));
+    for (const auto& material : model.mMaterials)
+    {
+        writer.WriteString(material.name);
+        writer.Write(material.diffuseTexture);
+    }
+
+    writer.Write(model.mNodes.GetNodeCount());
+    writer.WriteArray(Span<const uint32_t>(model.mNodes.GetParents()));
+    writer.WriteArray(Span<const glm::mat4>(model.mNodes.GetLocalTransforms()), DataAlignment);
+
+    writer.Write((uint32_t)std::size(model.mInstances));
+    writer.WriteArray(Span<const MeshInstance>(model.mInstances));
+
+    for (size_t meshIndex = 0; meshIndex < std::size(model.mMeshs); ++meshIndex)
+    {
+        const auto& mesh = model.mMeshs[meshIndex];
+        writer.WriteString(mesh->mName);
+        writer.Write(mesh->mMaterialIndex);
+        writer.Write(mesh->mBounds);
+
+        writer.Write((uint32_t)std::size(mesh->GetVertices()));
+        writer.Write(mesh->GetIndexCount());
+        writer.Write(uint32_t(mesh->GetIndexData().size_bytes() / vk::utils::GetIndexSize(mesh->GetIndexType())));
+        writer.Write((uint32_t)mesh->GetIndexType());
+        if (options.compressCache)
+        {
+            writer.Write((uint32_t)std::size(encodedVertices[meshIndex]));
+            writer.Write((uint32_t)std::size(encodedIndices[meshIndex]));
+            writer.WriteArray(Span<const uint8_t>(encodedVertices[meshIndex]));
+            writer.WriteArray(Span<const uint8_t>(encodedIndices[meshIndex]));
+        }
+        else
+        {
+            writer.WriteArray(mesh->GetVertices(), DataAlignment);
+            writer.WriteArray(mesh->GetIndexData(), DataAlignment);
+        }
+
+        writer.Write((uint32_t)std::size(mesh->GetLods()));
+        writer.WriteArray(mesh->GetLods(), DataAlignment);
+
+        writer.Write((uint32_t)std::size(mesh->GetMeshlets()));
+        writer.Write((uint32_t)std::size(mesh->GetMeshletVertices()));
+        writer.Write((uint32_t)std::size(mesh->GetMeshletTriangles()));
+        writer.WriteArray(mesh->GetMeshlets(), DataAlignment);
+        writer.WriteArray(mesh->GetMeshletVertices(), DataAlignment);
+        writer.WriteArray(mesh->GetMeshletTriangles(), DataAlignment);
+    }
+
+    // Write to a temporary file first so a partially written cache is never picked up
+    auto tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_WARN("Failed to open {0} for writing", tempPath.string());
+            return false;
+        }
+
+        const auto& buffer = writer.GetBuffer();
+        file.write((const char*)std::data(buffer), (std::streamsize)std::size(buffer));
+        if (!file)
+        {
+            LOG_WARN("Failed to write mesh cache {0}", tempPath.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec)
+    {
+        LOG_WARN("Failed to replace mesh cache {0}: {1}", cachePath.string(), ec.message());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    if (options.compressCache)
+    {
+        LOG_INFO("Wrote mesh cache {0}, mesh data compressed {1:.1f} MB -> {2:.1f} MB ({3:.2f}x)", cachePath.string(),
+            rawSize / 1e6, encodedSize / 1e6, encodedSize > 0 ? double(rawSize) / encodedSize : 0.0);
+    }
+    else
+        LOG_INFO("Wrote mesh cache {0}", cachePath.string());
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+class Model;
+struct ModelLoadOptions;
+
+// Versioned binary cache of fully processed model data stored next to the source asset.
+// A valid cache is memory mapped and the meshes reference its vertex/index data directly.
+class MeshCache
+{
+public:
+    static std::filesystem::path GetCachePath(const std::filesystem::path& sourcePath);
+
+    static std::unique_ptr<Model> Load(const std::filesystem::path& sourcePath, const ModelLoadOptions& options);
+    static bool Write(const std::filesystem::path& sourcePath, const ModelLoadOptions& options, const Model& model);
+};
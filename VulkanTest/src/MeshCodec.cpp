@@ -0,0 +1,425 @@
+#include "MeshCodec.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define MESH_CODEC_SSE 1
+#   include <emmintrin.h>
+#else
+#   define MESH_CODEC_SSE 0
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace MeshCodec
+{
+    namespace
+    {
+        constexpr size_t VertexSize = sizeof(Vertex);
+
+        // Streams are split into blocks that are compressed on their own, so decoding only needs a
+        // small buffer that stays in cache
+        constexpr size_t VertexBlockSize = 1024;
+        constexpr size_t IndexBlockSize = 8192;
+        // A 32-bit varint takes at most 5 bytes
+        constexpr size_t MaxVarintSize = 5;
+
+        // LZ4 style sequences: a token with the literal count and match length in its nibbles,
+        // the literals, then a 16-bit offset back into the output and the match length extension
+        constexpr size_t LzMinMatch = 4;
+        constexpr size_t LzMaxOffset = 0xffff;
+        constexpr uint32_t LzHashBits = 13;
+        constexpr uint32_t LzNoPosition = ~0u;
+        // Decode buffers have this much extra room so matches can be copied in 16 byte chunks
+        constexpr size_t LzCopySlack = 16;
+
+        uint32_t Read32(const uint8_t* src)
+        {
+            uint32_t value = 0;
+            memcpy(&value, src, sizeof(value));
+            return value;
+        }
+
+        void WriteLength(std::vector<uint8_t>& out, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+                out.push_back(255);
+            out.push_back((uint8_t)length);
+        }
+
+        // A match length of 0 writes the final sequence, which only has literals
+        void WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength)
+        {
+            uint8_t token = uint8_t(std::min<size_t>(literalCount, 15) << 4);
+            if (matchLength > 0)
+                token |= uint8_t(std::min<size_t>(matchLength - LzMinMatch, 15));
+            out.push_back(token);
+
+            if (literalCount >= 15)
+                WriteLength(out, literalCount - 15);
+            out.insert(std::end(out), literals, literals + literalCount);
+
+            if (matchLength == 0)
+                return;
+
+            out.push_back(uint8_t(offset));
+            out.push_back(uint8_t(offset >> 8));
+            if (matchLength - LzMinMatch >= 15)
+                WriteLength(out, matchLength - LzMinMatch - 15);
+        }
+
+        // Appends a block as its decoded size, its encoded size and the LZ sequences
+        void CompressBlock(const uint8_t* src, size_t size, std::vector<uint32_t>& table, std::vector<uint8_t>& out)
+        {
+            const size_t headerOffset = std::size(out);
+            out.resize(headerOffset + 2 * sizeof(uint32_t));
+            std::fill(std::begin(table), std::end(table), LzNoPosition);
+
+            size_t anchor = 0;
+            size_t i = 0;
+            while (size >= LzMinMatch && i <= size - LzMinMatch)
+            {
+                const uint32_t value = Read32(src + i);
+                const uint32_t hash = (value * 2654435761u) >> (32 - LzHashBits);
+                const uint32_t candidate = table[hash];
+                table[hash] = (uint32_t)i;
+
+                if (candidate == LzNoPosition || i - candidate > LzMaxOffset || Read32(src + candidate) != value)
+                {
+                    // Step faster through data that doesn't compress
+                    i += 1 + ((i - anchor) >> 6);
+                    continue;
+                }
+
+                size_t length = LzMinMatch;
+                while (i + length < size && src[candidate + length] == src[i + length])
+                    ++length;
+
+                WriteSequence(out, src + anchor, i - anchor, i - candidate, length);
+                i += length;
+                anchor = i;
+            }
+
+            WriteSequence(out, src + anchor, size - anchor, 0, 0);
+
+            const uint32_t header[2] = { (uint32_t)size, uint32_t(std::size(out) - headerOffset - sizeof(header)) };
+            memcpy(std::data(out) + headerOffset, header, sizeof(header));
+        }
+
+        // Decodes the block at src and moves src past it. dst needs LzCopySlack bytes of room past
+        // maxSize. Returns the decoded size.
+        size_t DecompressBlock(const uint8_t*& src, const uint8_t* srcEnd, uint8_t* dst, size_t maxSize)
+        {
+            uint32_t header[2] = {};
+            if (size_t(srcEnd - src) < sizeof(header))
+                throw std::runtime_error("Truncated mesh stream");
+            memcpy(header, src, sizeof(header));
+            src += sizeof(header);
+
+            const size_t decodedSize = header[0];
+            const size_t encodedSize = header[1];
+            if (decodedSize > maxSize || encodedSize > size_t(srcEnd - src))
+                throw std::runtime_error("Invalid mesh stream block");
+
+            const uint8_t* ip = src;
+            const uint8_t* const ipEnd = src + encodedSize;
+            uint8_t* op = dst;
+            uint8_t* const opEnd = dst + decodedSize;
+
+            const auto readLength = [&](size_t length) {
+                if (length != 15)
+                    return length;
+
+                uint8_t byte = 0;
+                do
+                {
+                    if (ip == ipEnd)
+                        throw std::runtime_error("Truncated mesh stream");
+                    byte = *ip++;
+                    length += byte;
+                } while (byte == 255);
+                return length;
+            };
+
+            while (true)
+            {
+                if (ip == ipEnd)
+                    throw std::runtime_error("Truncated mesh stream");
+                const uint8_t token = *ip++;
+
+                const size_t literalCount = readLength(token >> 4);
+                if (literalCount > size_t(ipEnd - ip) || literalCount > size_t(opEnd - op))
+                    throw std::runtime_error("Invalid literal run in mesh stream");
+                // Short runs are copied as one 16 byte chunk when the input has room to read it
+                if (literalCount <= 16 && ipEnd - ip >= 16)
+                    memcpy(op, ip, 16);
+                else
+                    memcpy(op, ip, literalCount);
+                ip += literalCount;
+                op += literalCount;
+
+                if (ip == ipEnd)
+                    break;
+
+                if (ipEnd - ip < 2)
+                    throw std::runtime_error("Truncated mesh stream");
+                const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+                ip += 2;
+
+                const size_t matchLength = readLength(token & 15) + LzMinMatch;
+                if (offset == 0 || offset > size_t(op - dst) || matchLength > size_t(opEnd - op))
+                    throw std::runtime_error("Invalid match in mesh stream");
+
+                const uint8_t* match = op - offset;
+                if (offset >= 16)
+                {
+                    // The last chunk may run into the slack, the source never overlaps what is written
+                    for (size_t copied = 0; copied < matchLength; copied += 16)
+                        memcpy(op + copied, match + copied, 16);
+                }
+                else if (offset >= 8)
+                {
+                    for (size_t copied = 0; copied < matchLength; copied += 8)
+                        memcpy(op + copied, match + copied, 8);
+                }
+                else if (offset == 1)
+                    memset(op, *match, matchLength);
+                else
+                {
+                    for (size_t i = 0; i < matchLength; ++i)
+                        op[i] = match[i];
+                }
+                op += matchLength;
+            }
+
+            if (op != opEnd)
+                throw std::runtime_error("Mesh stream block is shorter than its size");
+
+            src = ipEnd;
+            return decodedSize;
+        }
+
+#if MESH_CODEC_SSE
+        // Four rounds of interleaving row k with row k + 8 transpose a 16x16 byte matrix
+        void Transpose16x16(__m128i (&rows)[16])
+        {
+            for (int round = 0; round < 4; ++round)
+            {
+                __m128i shuffled[16];
+                for (int k = 0; k < 8; ++k)
+                {
+                    shuffled[k * 2] = _mm_unpacklo_epi8(rows[k], rows[k + 8]);
+                    shuffled[k * 2 + 1] = _mm_unpackhi_epi8(rows[k], rows[k + 8]);
+                }
+                for (int k = 0; k < 16; ++k)
+                    rows[k] = shuffled[k];
+            }
+        }
+
+        // Decodes groups of 16 vertices: 16 planes are transposed into 16 byte slices of 16 vertices,
+        // then the deltas are added up vertex by vertex. Returns the number of vertices decoded.
+        size_t UnfilterVerticesSSE(const uint8_t* planes, size_t vertexCount, uint8_t* dst, bool continues)
+        {
+            static_assert(VertexSize == 44, "The last slice is stored as 12 bytes");
+
+            alignas(16) uint8_t previousBytes[48] = {};
+            if (continues)
+                memcpy(previousBytes, dst - VertexSize, VertexSize);
+            __m128i previous[3];
+            for (size_t slice = 0; slice < 3; ++slice)
+                previous[slice] = _mm_load_si128((const __m128i*)(previousBytes + slice * 16));
+
+            const size_t groupCount = vertexCount / 16;
+            for (size_t group = 0; group < groupCount; ++group)
+            {
+                const size_t first = group * 16;
+                for (size_t slice = 0; slice < 3; ++slice)
+                {
+                    __m128i rows[16];
+                    for (size_t i = 0; i < 16; ++i)
+                    {
+                        const size_t plane = slice * 16 + i;
+                        rows[i] = plane < VertexSize ? _mm_loadu_si128((const __m128i*)(planes + plane * vertexCount + first)) : _mm_setzero_si128();
+                    }
+
+                    Transpose16x16(rows);
+
+                    for (size_t i = 0; i < 16; ++i)
+                    {
+                        previous[slice] = _mm_add_epi8(previous[slice], rows[i]);
+                        uint8_t* out = dst + (first + i) * VertexSize + slice * 16;
+                        if (slice < 2)
+                            _mm_storeu_si128((__m128i*)out, previous[slice]);
+                        else
+                        {
+                            _mm_storel_epi64((__m128i*)out, previous[slice]);
+                            const uint32_t tail = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(previous[slice], 8));
+                            memcpy(out + 8, &tail, sizeof(tail));
+                        }
+                    }
+                }
+            }
+
+            return groupCount * 16;
+        }
+#endif
+
+        // Reverses the byte plane filter of one block. continues is set when the block follows
+        // another one, its first vertex is then a delta to the vertex right before dst.
+        void UnfilterVertices(const uint8_t* planes, size_t vertexCount, uint8_t* dst, bool continues)
+        {
+            size_t i = 0;
+#if MESH_CODEC_SSE
+            i = UnfilterVerticesSSE(planes, vertexCount, dst, continues);
+#endif
+            for (; i < vertexCount; ++i)
+            {
+                uint8_t* vertex = dst + i * VertexSize;
+                for (size_t b = 0; b < VertexSize; ++b)
+                {
+                    const uint8_t previous = i > 0 || continues ? vertex[b - VertexSize] : 0;
+                    vertex[b] = uint8_t(planes[b * vertexCount + i] + previous);
+                }
+            }
+        }
+
+        template<typename T>
+        void DecodeIndexDeltas(const uint8_t* src, size_t size, uint8_t* dst, size_t indexCount, uint32_t& previous)
+        {
+            const uint8_t* const srcEnd = src + size;
+            for (size_t i = 0; i < indexCount; ++i)
+            {
+                uint32_t zigzag = 0;
+                for (uint32_t shift = 0;; shift += 7)
+                {
+                    if (src == srcEnd || shift > 28)
+                        throw std::runtime_error("Invalid index delta");
+                    const uint8_t byte = *src++;
+                    zigzag |= uint32_t(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0)
+                        break;
+                }
+
+                previous += (zigzag >> 1) ^ (0u - (zigzag & 1));
+                if (previous > std::numeric_limits<T>::max())
+                    throw std::runtime_error("Index out of range for its index type");
+
+                const T index = (T)previous;
+                memcpy(dst + i * sizeof(T), &index, sizeof(T));
+            }
+
+            if (src != srcEnd)
+                throw std::runtime_error("Unexpected data after the indices");
+        }
+    }
+
+    std::vector<uint8_t> EncodeVertices(Span<const Vertex> vertices)
+    {
+        const size_t count = std::size(vertices);
+        const uint8_t* bytes = (const uint8_t*)std::data(vertices);
+
+        std::vector<uint8_t> out;
+        std::vector<uint8_t> planes(std::min(count, VertexBlockSize) * VertexSize);
+        std::vector<uint32_t> table(size_t(1) << LzHashBits);
+        for (size_t first = 0; first < count; first += VertexBlockSize)
+        {
+            const size_t blockCount = std::min(VertexBlockSize, count - first);
+            for (size_t i = 0; i < blockCount; ++i)
+            {
+                const uint8_t* vertex = bytes + (first + i) * VertexSize;
+                for (size_t b = 0; b < VertexSize; ++b)
+                {
+                    const uint8_t previous = first + i > 0 ? vertex[b - VertexSize] : 0;
+                    planes[b * blockCount + i] = uint8_t(vertex[b] - previous);
+                }
+            }
+
+            CompressBlock(std::data(planes), blockCount * VertexSize, table, out);
+        }
+
+        return out;
+    }
+
+    void DecodeVertices(Span<const uint8_t> encoded, Vertex* dst, size_t vertexCount)
+    {
+        const uint8_t* src = std::data(encoded);
+        const uint8_t* const srcEnd = src + std::size(encoded);
+        uint8_t* out = (uint8_t*)dst;
+
+        std::vector<uint8_t> planes(std::min(vertexCount, VertexBlockSize) * VertexSize + LzCopySlack);
+        for (size_t first = 0; first < vertexCount; first += VertexBlockSize)
+        {
+            const size_t blockCount = std::min(VertexBlockSize, vertexCount - first);
+            if (DecompressBlock(src, srcEnd, std::data(planes), blockCount * VertexSize) != blockCount * VertexSize)
+                throw std::runtime_error("Vertex block doesn't match the vertex count");
+
+            UnfilterVertices(std::data(planes), blockCount, out + first * VertexSize, first > 0);
+        }
+
+        if (src != srcEnd)
+            throw std::runtime_error("Unexpected data after the vertices");
+    }
+
+    std::vector<uint8_t> EncodeIndices(Span<const uint8_t> indexData, VkIndexType indexType)
+    {
+        const size_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        const size_t indexCount = indexData.size_bytes() / indexSize;
+
+        std::vector<uint8_t> out;
+        std::vector<uint8_t> varints;
+        std::vector<uint32_t> table(size_t(1) << LzHashBits);
+        uint32_t previous = 0;
+        for (size_t first = 0; first < indexCount; first += IndexBlockSize)
+        {
+            varints.clear();
+            const size_t last = std::min(first + IndexBlockSize, indexCount);
+            for (size_t i = first; i < last; ++i)
+            {
+                uint32_t index = 0;
+                if (indexType == VK_INDEX_TYPE_UINT16)
+                {
+                    uint16_t index16 = 0;
+                    memcpy(&index16, std::data(indexData) + i * sizeof(uint16_t), sizeof(index16));
+                    index = index16;
+                }
+                else
+                    memcpy(&index, std::data(indexData) + i * sizeof(uint32_t), sizeof(index));
+
+                const uint32_t delta = index - previous;
+                uint32_t zigzag = (delta << 1) ^ uint32_t(int32_t(delta) >> 31);
+                previous = index;
+
+                for (; zigzag >= 0x80; zigzag >>= 7)
+                    varints.push_back(uint8_t(zigzag | 0x80));
+                varints.push_back((uint8_t)zigzag);
+            }
+
+            CompressBlock(std::data(varints), std::size(varints), table, out);
+        }
+
+        return out;
+    }
+
+    void DecodeIndices(Span<const uint8_t> encoded, uint8_t* dst, size_t indexCount, VkIndexType indexType)
+    {
+        const uint8_t* src = std::data(encoded);
+        const uint8_t* const srcEnd = src + std::size(encoded);
+        const size_t indexSize = indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+
+        std::vector<uint8_t> varints(std::min(indexCount, IndexBlockSize) * MaxVarintSize + LzCopySlack);
+        uint32_t previous = 0;
+        for (size_t first = 0; first < indexCount; first += IndexBlockSize)
+        {
+            const size_t blockCount = std::min(IndexBlockSize, indexCount - first);
+            const size_t size = DecompressBlock(src, srcEnd, std::data(varints), blockCount * MaxVarintSize);
+            if (indexType == VK_INDEX_TYPE_UINT16)
+                DecodeIndexDeltas<uint16_t>(std::data(varints), size, dst + first * indexSize, blockCount, previous);
+            else
+                DecodeIndexDeltas<uint32_t>(std::data(varints), size, dst + first * indexSize, blockCount, previous);
+        }
+
+        if (src != srcEnd)
+            throw std::runtime_error("Unexpected data after the indices");
+    }
+}
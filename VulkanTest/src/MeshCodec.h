@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "Span.h"
+#include "Vertex.h"
+
+// Lossless codec for mesh vertex and index data. Both streams are filtered into something that
+// compresses well and then go through a byte oriented LZ stage. Decoding throws std::runtime_error
+// on corrupt input.
+namespace MeshCodec
+{
+    // Vertices are split into byte planes, each byte is stored as the difference to the same
+    // byte of the previous vertex.
+    std::vector<uint8_t> EncodeVertices(Span<const Vertex> vertices);
+    void DecodeVertices(Span<const uint8_t> encoded, Vertex* dst, size_t vertexCount);
+
+    // Indices are stored as zigzag coded differences to the previous index, written as varints.
+    // The index data is 16 or 32 bits per index depending on indexType.
+    std::vector<uint8_t> EncodeIndices(Span<const uint8_t> indexData, VkIndexType indexType);
+    void DecodeIndices(Span<const uint8_t> encoded, uint8_t* dst, size_t indexCount, VkIndexType indexType);
+}
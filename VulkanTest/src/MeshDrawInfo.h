@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "PackedVertex.h"
+#include "Bounds.h"
+
+class Mesh;
+
+// Location of a single mesh instance's geometry inside the model's shared vertex and index buffers
+struct MeshDrawInfo
+{
+    const Mesh* mesh = nullptr;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    int32_t vertexOffset = 0;
+    VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+    PositionQuantization quantization;
+    uint32_t materialIndex = 0;
+    glm::mat4 transform{ 1.0f };
+    // Mesh bounds after the transform, for LOD selection and texture streaming
+    Bounds bounds;
+};
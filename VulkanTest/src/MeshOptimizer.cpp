@@ -0,0 +1,1121 @@
+#include "MeshOptimizer.h"
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <cstring>
+
+#include "HashUtils.h"
+
+namespace MeshOptimizer
+{
+    namespace
+    {
+        constexpr uint32_t ForsythCacheSize = 32;
+        constexpr uint32_t ForsythMaxValence = 32;
+        constexpr float LastTriScore = 0.75f;
+        constexpr float CacheDecayPower = 1.5f;
+        constexpr float ValenceBoostScale = 2.0f;
+        constexpr float ValenceBoostPower = 0.5f;
+
+        struct ForsythScoreTables
+        {
+            std::array<float, ForsythCacheSize> cache{};
+            std::array<float, ForsythMaxValence> valence{};
+
+            ForsythScoreTables()
+            {
+                for (uint32_t i = 0; i < ForsythCacheSize; ++i)
+                {
+                    if (i < 3)
+                        cache[i] = LastTriScore;
+                    else
+                        cache[i] = std::pow(1.0f - float(i - 3) / float(ForsythCacheSize - 3), CacheDecayPower);
+                }
+
+                for (uint32_t i = 1; i < ForsythMaxValence; ++i)
+                    valence[i] = ValenceBoostScale * std::pow(float(i), -ValenceBoostPower);
+            }
+        };
+
+        float ForsythVertexScore(const ForsythScoreTables& tables, int32_t cachePos, uint32_t liveTris)
+        {
+            if (liveTris == 0)
+                return -1.0f;
+
+            float score = cachePos >= 0 ? tables.cache[cachePos] : 0.0f;
+            if (liveTris < ForsythMaxValence)
+                score += tables.valence[liveTris];
+            else
+                score += ValenceBoostScale * std::pow(float(liveTris), -ValenceBoostPower);
+
+            return score;
+        }
+
+        constexpr uint32_t FetchCacheLineSize = 64;
+        constexpr uint32_t FetchCacheLineCount = 16 * 1024 / FetchCacheLineSize;
+
+        constexpr uint32_t OverdrawViewportSize = 256;
+        constexpr uint32_t OverdrawCacheSize = 16;
+
+        struct OverdrawBuffer
+        {
+            std::vector<float> depth;
+            std::vector<bool> covered;
+        };
+
+        void RasterizeOverdraw(OverdrawBuffer& buffer, OverdrawStats& stats,
+            glm::vec3 v0, glm::vec3 v1, glm::vec3 v2)
+        {
+            // Counter clockwise in screen space
+            float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+            if (area == 0.0f)
+                return;
+            if (area < 0.0f)
+            {
+                std::swap(v1, v2);
+                area = -area;
+            }
+
+            const int32_t minX = std::max((int32_t)std::floor(std::min({ v0.x, v1.x, v2.x })), 0);
+            const int32_t minY = std::max((int32_t)std::floor(std::min({ v0.y, v1.y, v2.y })), 0);
+            const int32_t maxX = std::min((int32_t)std::ceil(std::max({ v0.x, v1.x, v2.x })), (int32_t)OverdrawViewportSize - 1);
+            const int32_t maxY = std::min((int32_t)std::ceil(std::max({ v0.y, v1.y, v2.y })), (int32_t)OverdrawViewportSize - 1);
+
+            const float invArea = 1.0f / area;
+            for (int32_t y = minY; y <= maxY; ++y)
+            {
+                for (int32_t x = minX; x <= maxX; ++x)
+                {
+                    const float px = float(x) + 0.5f;
+                    const float py = float(y) + 0.5f;
+
+                    const float w0 = (v2.x - v1.x) * (py - v1.y) - (v2.y - v1.y) * (px - v1.x);
+                    const float w1 = (v0.x - v2.x) * (py - v2.y) - (v0.y - v2.y) * (px - v2.x);
+                    const float w2 = (v1.x - v0.x) * (py - v0.y) - (v1.y - v0.y) * (px - v0.x);
+                    if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                        continue;
+
+                    const float z = (w0 * v0.z + w1 * v1.z + w2 * v2.z) * invArea;
+                    const size_t pixel = size_t(y) * OverdrawViewportSize + size_t(x);
+                    if (z < buffer.depth[pixel])
+                    {
+                        buffer.depth[pixel] = z;
+                        ++stats.pixelsShaded;
+
+                        if (!buffer.covered[pixel])
+                        {
+                            buffer.covered[pixel] = true;
+                            ++stats.pixelsCovered;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Cache with a timestamp per vertex, advancing the time past the cache size flushes it
+        struct CacheSimulator
+        {
+            std::vector<uint32_t> insertedAt;
+            uint32_t time = 0;
+
+            CacheSimulator(size_t vertexCount) : insertedAt(vertexCount, 0) { Reset(); }
+
+            void Reset() { time += OverdrawCacheSize + 1; }
+
+            uint32_t Access(const uint32_t* tri)
+            {
+                uint32_t misses = 0;
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    if (time - insertedAt[tri[k]] > OverdrawCacheSize)
+                    {
+                        insertedAt[tri[k]] = time++;
+                        ++misses;
+                    }
+                }
+                return misses;
+            }
+        };
+
+        void ComputeMeshletBounds(Meshlet& meshlet, const MeshletData& data, Span<const Vertex> vertices)
+        {
+            const uint32_t* meshletVerts = &data.vertices[meshlet.vertexOffset];
+            const uint8_t* meshletTris = &data.triangles[meshlet.triangleOffset];
+
+            glm::vec3 min = vertices[meshletVerts[0]].pos;
+            glm::vec3 max = min;
+            for (uint32_t i = 1; i < meshlet.vertexCount; ++i)
+            {
+                min = glm::min(min, vertices[meshletVerts[i]].pos);
+                max = glm::max(max, vertices[meshletVerts[i]].pos);
+            }
+
+            meshlet.center = (min + max) * 0.5f;
+            meshlet.radius = 0.0f;
+            for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+                meshlet.radius = std::max(meshlet.radius, glm::length(vertices[meshletVerts[i]].pos - meshlet.center));
+
+            std::array<glm::vec3, Meshlet::MaxTriangles> normals;
+            uint32_t normalCount = 0;
+            glm::vec3 axis(0.0f);
+            for (uint32_t tri = 0; tri < meshlet.triangleCount; ++tri)
+            {
+                const glm::vec3& p0 = vertices[meshletVerts[meshletTris[tri * 3 + 0]]].pos;
+                const glm::vec3& p1 = vertices[meshletVerts[meshletTris[tri * 3 + 1]]].pos;
+                const glm::vec3& p2 = vertices[meshletVerts[meshletTris[tri * 3 + 2]]].pos;
+
+                const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                const float length = glm::length(normal);
+                if (length == 0.0f)
+                    continue;
+
+                normals[normalCount] = normal / length;
+                axis += normals[normalCount++];
+            }
+
+            meshlet.coneAxis = glm::vec3(0.0f);
+            meshlet.coneCutoff = 1.0f;
+
+            const float axisLength = glm::length(axis);
+            if (normalCount == 0 || axisLength == 0.0f)
+                return;
+
+            axis /= axisLength;
+            float minDot = 1.0f;
+            for (uint32_t i = 0; i < normalCount; ++i)
+                minDot = std::min(minDot, glm::dot(axis, normals[i]));
+
+            meshlet.coneAxis = axis;
+            // Wider than ~84 degrees can hardly ever be culled
+            if (minDot > 0.1f)
+                meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+        }
+
+        constexpr float SimplifyBorderWeight = 10.0f;
+        constexpr float SimplifyAttributeWeight = 0.5f;
+
+        // Symmetric 4x4 error quadric accumulated from weighted planes
+        struct Quadric
+        {
+            double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+            double a11 = 0, a12 = 0, a13 = 0;
+            double a22 = 0, a23 = 0;
+            double a33 = 0;
+            double weight = 0;
+
+            static Quadric FromPlane(const glm::vec3& n, float d, float weight)
+            {
+                Quadric q;
+                q.a00 = weight * n.x * n.x; q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z; q.a03 = weight * n.x * d;
+                q.a11 = weight * n.y * n.y; q.a12 = weight * n.y * n.z; q.a13 = weight * n.y * d;
+                q.a22 = weight * n.z * n.z; q.a23 = weight * n.z * d;
+                q.a33 = weight * d * d;
+                q.weight = weight;
+                return q;
+            }
+
+            Quadric& operator+=(const Quadric& o)
+            {
+                a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+                a11 += o.a11; a12 += o.a12; a13 += o.a13;
+                a22 += o.a22; a23 += o.a23;
+                a33 += o.a33;
+                weight += o.weight;
+                return *this;
+            }
+
+            double Evaluate(const glm::vec3& p) const
+            {
+                const double x = p.x, y = p.y, z = p.z;
+                const double error = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x +
+                    a11 * y * y + 2 * a12 * y * z + 2 * a13 * y +
+                    a22 * z * z + 2 * a23 * z + a33;
+                return std::max(error, 0.0);
+            }
+        };
+
+        struct Collapse
+        {
+            uint32_t from = 0;
+            uint32_t to = 0;
+            double cost = 0;
+        };
+
+        float AttributeDistance(const Vertex& a, const Vertex& b)
+        {
+            const glm::vec3 normal = a.normal - b.normal;
+            const glm::vec3 color = a.color - b.color;
+            const glm::vec2 texCoord = a.texCoord - b.texCoord;
+            return glm::dot(normal, normal) + glm::dot(color, color) + glm::dot(texCoord, texCoord);
+        }
+
+        // Vertex to triangle adjacency in compressed rows
+        struct TriangleAdjacency
+        {
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> triangles;
+
+            void Build(const std::vector<uint32_t>& indices, size_t vertexCount)
+            {
+                offsets.assign(vertexCount + 1, 0);
+                for (const uint32_t index : indices)
+                    ++offsets[index + 1];
+                for (size_t i = 0; i < vertexCount; ++i)
+                    offsets[i + 1] += offsets[i];
+
+                triangles.resize(std::size(indices));
+                std::vector<uint32_t> fill(std::begin(offsets), std::end(offsets) - 1);
+                for (size_t i = 0; i < std::size(indices); ++i)
+                    triangles[fill[indices[i]]++] = uint32_t(i / 3);
+            }
+
+            Span<const uint32_t> Get(uint32_t vertex) const
+            {
+                return { std::data(triangles) + offsets[vertex], size_t(offsets[vertex + 1] - offsets[vertex]) };
+            }
+        };
+    }
+
+    VertexCacheStats AnalyzeVertexCache(Span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStats stats;
+        if (std::empty(indices) || vertexCount == 0)
+            return stats;
+
+        // Timestamp based FIFO: a vertex is in the cache if it was inserted less than cacheSize misses ago
+        std::vector<uint32_t> insertedAt(vertexCount, 0);
+        std::vector<bool> referenced(vertexCount, false);
+        uint32_t referencedCount = 0;
+        uint32_t time = cacheSize + 1;
+
+        for (const uint32_t index : indices)
+        {
+            if (time - insertedAt[index] > cacheSize)
+            {
+                insertedAt[index] = time++;
+                ++stats.vertexTransforms;
+            }
+
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                ++referencedCount;
+            }
+        }
+
+        stats.acmr = float(stats.vertexTransforms) / float(std::size(indices) / 3);
+        stats.atvr = float(stats.vertexTransforms) / float(referencedCount);
+        return stats;
+    }
+
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+    {
+        const size_t triCount = std::size(indices) / 3;
+        if (triCount == 0 || vertexCount == 0)
+            return;
+
+        static const ForsythScoreTables tables;
+
+        // Triangle adjacency per vertex, the live triangles of vertex v are
+        // adjacency[offsets[v] .. offsets[v] + liveTris[v])
+        std::vector<uint32_t> liveTris(vertexCount, 0);
+        for (const uint32_t index : indices)
+            ++liveTris[index];
+
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; ++v)
+            offsets[v + 1] = offsets[v] + liveTris[v];
+
+        std::vector<uint32_t> adjacency(std::size(indices));
+        {
+            std::vector<uint32_t> fill(std::begin(offsets), std::end(offsets) - 1);
+            for (size_t t = 0; t < triCount; ++t)
+            {
+                for (size_t k = 0; k < 3; ++k)
+                    adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+            }
+        }
+
+        std::vector<int32_t> cachePos(vertexCount, -1);
+        std::vector<float> vertexScores(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v)
+            vertexScores[v] = ForsythVertexScore(tables, -1, liveTris[v]);
+
+        std::vector<float> triScores(triCount);
+        std::vector<bool> emitted(triCount, false);
+        for (size_t t = 0; t < triCount; ++t)
+        {
+            triScores[t] = vertexScores[indices[t * 3 + 0]] +
+                vertexScores[indices[t * 3 + 1]] +
+                vertexScores[indices[t * 3 + 2]];
+        }
+
+        std::vector<uint32_t> output;
+        output.reserve(std::size(indices));
+
+        std::array<uint32_t, ForsythCacheSize + 3> cache{};
+        std::array<uint32_t, ForsythCacheSize + 3> newCache{};
+        uint32_t cacheCount = 0;
+
+        int64_t bestTri = std::max_element(std::begin(triScores), std::end(triScores)) - std::begin(triScores);
+        size_t fallbackCursor = 0;
+
+        while (std::size(output) < std::size(indices))
+        {
+            if (bestTri < 0)
+            {
+                // Dead end, continue with the next triangle in input order
+                while (emitted[fallbackCursor])
+                    ++fallbackCursor;
+                bestTri = (int64_t)fallbackCursor;
+            }
+
+            const uint32_t* tri = &indices[size_t(bestTri) * 3];
+            emitted[bestTri] = true;
+
+            uint32_t newCacheCount = 0;
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const uint32_t v = tri[k];
+                output.push_back(v);
+
+                // Remove the triangle from the vertex's live triangle list
+                uint32_t* vertexTris = &adjacency[offsets[v]];
+                for (uint32_t i = 0; i < liveTris[v]; ++i)
+                {
+                    if (vertexTris[i] == (uint32_t)bestTri)
+                    {
+                        std::swap(vertexTris[i], vertexTris[liveTris[v] - 1]);
+                        break;
+                    }
+                }
+                --liveTris[v];
+
+                newCache[newCacheCount++] = v;
+            }
+
+            // The emitted triangle's vertices move to the front of the LRU cache
+            for (uint32_t i = 0; i < cacheCount; ++i)
+            {
+                const uint32_t v = cache[i];
+                if (v != tri[0] && v != tri[1] && v != tri[2])
+                    newCache[newCacheCount++] = v;
+            }
+
+            // Vertices pushed out of the cache lose their cache score
+            for (uint32_t i = ForsythCacheSize; i < newCacheCount; ++i)
+            {
+                const uint32_t v = newCache[i];
+                cachePos[v] = -1;
+
+                const float score = ForsythVertexScore(tables, -1, liveTris[v]);
+                const float delta = score - vertexScores[v];
+                vertexScores[v] = score;
+                for (uint32_t j = 0; j < liveTris[v]; ++j)
+                    triScores[adjacency[offsets[v] + j]] += delta;
+            }
+
+            cacheCount = std::min(newCacheCount, ForsythCacheSize);
+            std::copy_n(std::begin(newCache), cacheCount, std::begin(cache));
+
+            bestTri = -1;
+            float bestScore = -1.0f;
+            for (uint32_t i = 0; i < cacheCount; ++i)
+            {
+                const uint32_t v = cache[i];
+                cachePos[v] = (int32_t)i;
+
+                const float score = ForsythVertexScore(tables, (int32_t)i, liveTris[v]);
+                const float delta = score - vertexScores[v];
+                vertexScores[v] = score;
+                for (uint32_t j = 0; j < liveTris[v]; ++j)
+                    triScores[adjacency[offsets[v] + j]] += delta;
+            }
+
+            for (uint32_t i = 0; i < cacheCount; ++i)
+            {
+                const uint32_t v = cache[i];
+                for (uint32_t j = 0; j < liveTris[v]; ++j)
+                {
+                    const uint32_t t = adjacency[offsets[v] + j];
+                    if (triScores[t] > bestScore)
+                    {
+                        bestScore = triScores[t];
+                        bestTri = t;
+                    }
+                }
+            }
+        }
+
+        indices = std::move(output);
+    }
+
+    OverdrawStats AnalyzeOverdraw(Span<const uint32_t> indices, Span<const Vertex> vertices)
+    {
+        OverdrawStats stats;
+        if (std::empty(indices) || std::empty(vertices))
+            return stats;
+
+        glm::vec3 minPos(std::numeric_limits<float>::max());
+        glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+        for (const uint32_t index : indices)
+        {
+            minPos = glm::min(minPos, vertices[index].pos);
+            maxPos = glm::max(maxPos, vertices[index].pos);
+        }
+
+        const glm::vec3 extent = maxPos - minPos;
+        const float scale = 1.0f / std::max({ extent.x, extent.y, extent.z, std::numeric_limits<float>::min() });
+
+        OverdrawBuffer buffer;
+        buffer.depth.resize(size_t(OverdrawViewportSize) * OverdrawViewportSize);
+        buffer.covered.resize(size_t(OverdrawViewportSize) * OverdrawViewportSize);
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            for (int direction = 0; direction < 2; ++direction)
+            {
+                std::fill(std::begin(buffer.depth), std::end(buffer.depth), std::numeric_limits<float>::max());
+                std::fill(std::begin(buffer.covered), std::end(buffer.covered), false);
+
+                const int axisU = (axis + 1) % 3;
+                const int axisV = (axis + 2) % 3;
+                const float facing = direction == 0 ? -1.0f : 1.0f;
+
+                for (size_t t = 0; t < std::size(indices) / 3; ++t)
+                {
+                    const glm::vec3 p0 = (vertices[indices[t * 3 + 0]].pos - minPos) * scale;
+                    const glm::vec3 p1 = (vertices[indices[t * 3 + 1]].pos - minPos) * scale;
+                    const glm::vec3 p2 = (vertices[indices[t * 3 + 2]].pos - minPos) * scale;
+
+                    // Back-face culling, the camera looks along +axis for direction 0 and -axis for direction 1
+                    const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                    if (normal[axis] * facing <= 0.0f)
+                        continue;
+
+                    const auto project = [&](const glm::vec3& p) {
+                        const float depth = direction == 0 ? p[axis] : 1.0f - p[axis];
+                        return glm::vec3(p[axisU] * (OverdrawViewportSize - 1), p[axisV] * (OverdrawViewportSize - 1), depth);
+                    };
+
+                    RasterizeOverdraw(buffer, stats, project(p0), project(p1), project(p2));
+                }
+            }
+        }
+
+        stats.overdraw = stats.pixelsCovered > 0 ? float(stats.pixelsShaded) / float(stats.pixelsCovered) : 0.0f;
+        return stats;
+    }
+
+    void OptimizeOverdraw(std::vector<uint32_t>& indices, Span<const Vertex> vertices, float threshold)
+    {
+        const size_t triCount = std::size(indices) / 3;
+        if (triCount == 0)
+            return;
+
+        CacheSimulator cache(std::size(vertices));
+
+        // Hard boundaries are triangles where all three vertices miss the cache,
+        // starting a new cluster there doesn't cost any extra vertex transforms.
+        std::vector<uint32_t> misses(triCount);
+        std::vector<uint32_t> hardClusters;
+        for (size_t t = 0; t < triCount; ++t)
+        {
+            misses[t] = cache.Access(&indices[t * 3]);
+            if (t == 0 || misses[t] == 3)
+                hardClusters.push_back((uint32_t)t);
+        }
+        hardClusters.push_back((uint32_t)triCount);
+
+        // Soft boundaries split the hard clusters further as soon as the ACMR of the
+        // current sub-cluster, simulated with a flushed cache, drops below the threshold.
+        std::vector<uint32_t> clusters;
+        for (size_t c = 0; c + 1 < std::size(hardClusters); ++c)
+        {
+            const uint32_t start = hardClusters[c];
+            const uint32_t end = hardClusters[c + 1];
+
+            uint32_t clusterMisses = 0;
+            for (uint32_t t = start; t < end; ++t)
+                clusterMisses += misses[t];
+
+            const float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+
+            clusters.push_back(start);
+            cache.Reset();
+
+            uint32_t runningMisses = 0;
+            uint32_t runningTris = 0;
+            for (uint32_t t = start; t < end; ++t)
+            {
+                runningMisses += cache.Access(&indices[size_t(t) * 3]);
+                ++runningTris;
+
+                if (t + 1 < end && float(runningMisses) / float(runningTris) <= clusterThreshold)
+                {
+                    clusters.push_back(t + 1);
+                    cache.Reset();
+                    runningMisses = 0;
+                    runningTris = 0;
+                }
+            }
+        }
+        clusters.push_back((uint32_t)triCount);
+
+        // Sort clusters by how far they face away from the mesh center, outward
+        // facing clusters on the hull are likely to occlude everything else.
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+
+        const size_t clusterCount = std::size(clusters) - 1;
+        std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+        std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+
+        for (size_t c = 0; c < clusterCount; ++c)
+        {
+            float clusterArea = 0.0f;
+            for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t)
+            {
+                const glm::vec3& p0 = vertices[indices[size_t(t) * 3 + 0]].pos;
+                const glm::vec3& p1 = vertices[indices[size_t(t) * 3 + 1]].pos;
+                const glm::vec3& p2 = vertices[indices[size_t(t) * 3 + 2]].pos;
+
+                const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+                const float area = glm::length(normal);
+
+                clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+                clusterNormals[c] += normal;
+                clusterArea += area;
+            }
+
+            meshCentroid += clusterCentroids[c];
+            meshArea += clusterArea;
+
+            if (clusterArea > 0.0f)
+                clusterCentroids[c] /= clusterArea;
+
+            const float normalLength = glm::length(clusterNormals[c]);
+            if (normalLength > 0.0f)
+                clusterNormals[c] /= normalLength;
+        }
+
+        if (meshArea > 0.0f)
+            meshCentroid /= meshArea;
+
+        std::vector<float> sortKeys(clusterCount);
+        for (size_t c = 0; c < clusterCount; ++c)
+            sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]);
+
+        std::vector<uint32_t> order(clusterCount);
+        for (size_t c = 0; c < clusterCount; ++c)
+            order[c] = (uint32_t)c;
+
+        std::stable_sort(std::begin(order), std::end(order),
+            [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+        std::vector<uint32_t> output;
+        output.reserve(std::size(indices));
+        for (const uint32_t c : order)
+        {
+            output.insert(std::end(output),
+                std::begin(indices) + size_t(clusters[c]) * 3,
+                std::begin(indices) + size_t(clusters[c + 1]) * 3);
+        }
+
+        indices = std::move(output);
+    }
+
+    VertexFetchStats AnalyzeVertexFetch(Span<const uint32_t> indices, size_t vertexCount, size_t vertexSize)
+    {
+        VertexFetchStats stats;
+        if (std::empty(indices) || vertexCount == 0)
+            return stats;
+
+        const size_t lineCount = (vertexCount * vertexSize + FetchCacheLineSize - 1) / FetchCacheLineSize;
+        std::vector<uint32_t> lineInsertedAt(lineCount, 0);
+        std::vector<bool> referenced(vertexCount, false);
+        uint64_t referencedCount = 0;
+        uint32_t time = FetchCacheLineCount + 1;
+
+        for (const uint32_t index : indices)
+        {
+            if (!referenced[index])
+            {
+                referenced[index] = true;
+                ++referencedCount;
+            }
+
+            const size_t firstLine = index * vertexSize / FetchCacheLineSize;
+            const size_t lastLine = ((index + 1) * vertexSize - 1) / FetchCacheLineSize;
+            for (size_t line = firstLine; line <= lastLine; ++line)
+            {
+                if (time - lineInsertedAt[line] > FetchCacheLineCount)
+                {
+                    lineInsertedAt[line] = time++;
+                    stats.bytesFetched += FetchCacheLineSize;
+                }
+            }
+        }
+
+        stats.overfetch = float(stats.bytesFetched) / float(referencedCount * vertexSize);
+        return stats;
+    }
+
+    std::vector<Vertex> OptimizeVertexFetch(std::vector<uint32_t>& indices, Span<const Vertex> vertices)
+    {
+        constexpr uint32_t Unused = std::numeric_limits<uint32_t>::max();
+
+        std::vector<uint32_t> remap(std::size(vertices), Unused);
+        std::vector<Vertex> result;
+        result.reserve(std::size(vertices));
+
+        for (uint32_t& index : indices)
+        {
+            if (remap[index] == Unused)
+            {
+                remap[index] = (uint32_t)std::size(result);
+                result.push_back(vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        return result;
+    }
+
+    MeshletData BuildMeshlets(Span<const uint32_t> indices, Span<const Vertex> vertices)
+    {
+        constexpr uint8_t NotInMeshlet = 0xff;
+
+        MeshletData data;
+        data.meshlets.reserve(std::size(indices) / 3 / Meshlet::MaxTriangles + 1);
+
+        // Local index of each mesh vertex in the meshlet being built
+        std::vector<uint8_t> localIndex(std::size(vertices), NotInMeshlet);
+        Meshlet meshlet;
+
+        const auto finishMeshlet = [&]() {
+            for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+                localIndex[data.vertices[meshlet.vertexOffset + i]] = NotInMeshlet;
+
+            ComputeMeshletBounds(meshlet, data, vertices);
+            data.meshlets.push_back(meshlet);
+
+            data.triangles.resize((std::size(data.triangles) + 3) & ~size_t(3));
+            meshlet = Meshlet();
+            meshlet.vertexOffset = (uint32_t)std::size(data.vertices);
+            meshlet.triangleOffset = (uint32_t)std::size(data.triangles);
+        };
+
+        for (size_t i = 0; i + 2 < std::size(indices); i += 3)
+        {
+            const uint32_t tri[3] = { indices[i], indices[i + 1], indices[i + 2] };
+
+            uint32_t newVertices = 0;
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                if (localIndex[tri[corner]] == NotInMeshlet &&
+                    (corner < 1 || tri[corner] != tri[0]) && (corner < 2 || tri[corner] != tri[1]))
+                    ++newVertices;
+            }
+
+            if (meshlet.vertexCount + newVertices > Meshlet::MaxVertices ||
+                meshlet.triangleCount + 1 > Meshlet::MaxTriangles)
+                finishMeshlet();
+
+            for (int corner = 0; corner < 3; ++corner)
+            {
+                uint8_t& local = localIndex[tri[corner]];
+                if (local == NotInMeshlet)
+                {
+                    local = (uint8_t)meshlet.vertexCount++;
+                    data.vertices.push_back(tri[corner]);
+                }
+
+                data.triangles.push_back(local);
+            }
+
+            ++meshlet.triangleCount;
+        }
+
+        if (meshlet.triangleCount > 0)
+            finishMeshlet();
+
+        return data;
+    }
+
+    std::vector<uint32_t> Simplify(Span<const uint32_t> indices, Span<const Vertex> vertices, size_t targetIndexCount, float& resultError)
+    {
+        constexpr uint32_t Invalid = std::numeric_limits<uint32_t>::max();
+
+        resultError = 0.0f;
+        std::vector<uint32_t> result(std::begin(indices), std::end(indices));
+        const size_t vertexCount = std::size(vertices);
+        if (std::size(result) <= targetIndexCount || vertexCount == 0)
+            return result;
+
+        // Work in a unit sized space so the weights don't depend on the scale of the mesh
+        glm::vec3 min = vertices[0].pos;
+        glm::vec3 max = vertices[0].pos;
+        for (const auto& vertex : vertices)
+        {
+            min = glm::min(min, vertex.pos);
+            max = glm::max(max, vertex.pos);
+        }
+
+        const float extent = std::max({ max.x - min.x, max.y - min.y, max.z - min.z, 1e-20f });
+        std::vector<glm::vec3> positions(vertexCount);
+        for (size_t i = 0; i < vertexCount; ++i)
+            positions[i] = (vertices[i].pos - min) / extent;
+
+        // Vertices sharing a position (normal and UV seams) collapse together as one group
+        std::vector<uint32_t> group(vertexCount);
+        std::vector<uint32_t> groupLeader;
+        {
+            std::unordered_map<glm::vec3, uint32_t> groupIds;
+            for (uint32_t i = 0; i < vertexCount; ++i)
+            {
+                const auto [it, inserted] = groupIds.emplace(vertices[i].pos, (uint32_t)std::size(groupLeader));
+                if (inserted)
+                    groupLeader.push_back(i);
+                group[i] = it->second;
+            }
+        }
+        const size_t groupCount = std::size(groupLeader);
+
+        const auto edgeKey = [](uint32_t a, uint32_t b) {
+            return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+        };
+
+
+        const auto removeDegenerateTriangles = [&]() {
+            size_t write = 0;
+            for (size_t i = 0; i < std::size(result); i += 3)
+            {
+                const uint32_t g0 = group[result[i]];
+                const uint32_t g1 = group[result[i + 1]];
+                const uint32_t g2 = group[result[i + 2]];
+                if (g0 == g1 || g1 == g2 || g0 == g2)
+                    continue;
+
+                for (size_t k = 0; k < 3; ++k)
+                    result[write++] = result[i + k];
+            }
+            result.resize(write);
+        };
+
+        removeDegenerateTriangles();
+
+        std::unordered_map<uint64_t, uint32_t> edgeCounts;
+        for (size_t i = 0; i < std::size(result); i += 3)
+        {
+            for (size_t k = 0; k < 3; ++k)
+                ++edgeCounts[edgeKey(group[result[i + k]], group[result[i + (k + 1) % 3]])];
+        }
+
+        // Plane quadrics weighted by area, plus perpendicular planes along open borders to keep their shape
+        std::vector<Quadric> quadrics(groupCount);
+        std::vector<bool> border(groupCount, false);
+        for (size_t i = 0; i < std::size(result); i += 3)
+        {
+            const glm::vec3& p0 = positions[result[i]];
+            const glm::vec3& p1 = positions[result[i + 1]];
+            const glm::vec3& p2 = positions[result[i + 2]];
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            const float length = glm::length(normal);
+            if (length == 0.0f)
+                continue;
+            normal /= length;
+
+            const Quadric quadric = Quadric::FromPlane(normal, -glm::dot(normal, p0), length * 0.5f);
+            for (size_t k = 0; k < 3; ++k)
+                quadrics[group[result[i + k]]] += quadric;
+
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const uint32_t a = result[i + k];
+                const uint32_t b = result[i + (k + 1) % 3];
+                if (edgeCounts[edgeKey(group[a], group[b])] != 1)
+                    continue;
+
+                border[group[a]] = true;
+                border[group[b]] = true;
+
+                const glm::vec3 edge = positions[b] - positions[a];
+                const glm::vec3 planeNormal = glm::normalize(glm::cross(edge, normal));
+                const Quadric borderQuadric = Quadric::FromPlane(planeNormal, -glm::dot(planeNormal, positions[a]),
+                    glm::dot(edge, edge) * SimplifyBorderWeight);
+                quadrics[group[a]] += borderQuadric;
+                quadrics[group[b]] += borderQuadric;
+            }
+        }
+
+        TriangleAdjacency adjacency;
+        std::vector<uint32_t> groupVertexOffsets(groupCount + 1);
+        std::vector<uint32_t> groupVertices;
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<bool> locked(groupCount);
+        std::vector<Collapse> collapses;
+        double maxError = 0.0;
+
+        // Finds the vertex of the target group that a vertex collapses onto, which has to share a triangle
+        // with it so that each side of a seam collapses along its own edge
+        const auto findTarget = [&](uint32_t vertex, uint32_t toGroup) {
+            for (const uint32_t tri : adjacency.Get(vertex))
+            {
+                for (size_t k = 0; k < 3; ++k)
+                {
+                    if (group[result[tri * 3 + k]] == toGroup)
+                        return result[tri * 3 + k];
+                }
+            }
+            return Invalid;
+        };
+
+        const auto getGroupVertices = [&](uint32_t g) {
+            return Span<const uint32_t>(std::data(groupVertices) + groupVertexOffsets[g],
+                size_t(groupVertexOffsets[g + 1] - groupVertexOffsets[g]));
+        };
+
+        const auto countSharedTriangles = [&](uint32_t a, uint32_t b) {
+            uint32_t count = 0;
+            for (const uint32_t vertex : getGroupVertices(a))
+            {
+                for (const uint32_t tri : adjacency.Get(vertex))
+                {
+                    for (size_t k = 0; k < 3; ++k)
+                        count += group[result[tri * 3 + k]] == b ? 1 : 0;
+                }
+            }
+            return count;
+        };
+
+        const auto flipsTriangles = [&](const Collapse& collapse) {
+            const glm::vec3& target = positions[groupLeader[collapse.to]];
+            for (const uint32_t vertex : getGroupVertices(collapse.from))
+            {
+                for (const uint32_t tri : adjacency.Get(vertex))
+                {
+                    std::array<glm::vec3, 3> p;
+                    bool collapsing = false;
+                    for (size_t k = 0; k < 3; ++k)
+                    {
+                        const uint32_t index = result[tri * 3 + k];
+                        collapsing |= group[index] == collapse.to;
+                        p[k] = positions[index];
+                    }
+
+                    if (collapsing)
+                        continue;
+
+                    const glm::vec3 oldNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    for (size_t k = 0; k < 3; ++k)
+                    {
+                        if (result[tri * 3 + k] == vertex)
+                            p[k] = target;
+                    }
+
+                    const glm::vec3 newNormal = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    // Also reject triangles that turn too far, they are close to folding over
+                    if (glm::dot(oldNormal, newNormal) <= 0.25f * glm::length(oldNormal) * glm::length(newNormal))
+                        return true;
+                }
+            }
+            return false;
+        };
+
+        while (std::size(result) / 3 > targetIndexCount / 3)
+        {
+            adjacency.Build(result, vertexCount);
+
+            std::fill(std::begin(groupVertexOffsets), std::end(groupVertexOffsets), 0);
+            for (uint32_t v = 0; v < vertexCount; ++v)
+            {
+                if (!std::empty(adjacency.Get(v)))
+                    ++groupVertexOffsets[group[v] + 1];
+            }
+            for (size_t g = 0; g < groupCount; ++g)
+                groupVertexOffsets[g + 1] += groupVertexOffsets[g];
+
+            groupVertices.resize(groupVertexOffsets[groupCount]);
+            {
+                std::vector<uint32_t> fill(std::begin(groupVertexOffsets), std::end(groupVertexOffsets) - 1);
+                for (uint32_t v = 0; v < vertexCount; ++v)
+                {
+                    if (!std::empty(adjacency.Get(v)))
+                        groupVertices[fill[group[v]]++] = v;
+                }
+            }
+
+            // Pick the cheapest valid collapse for every group
+            collapses.clear();
+            for (uint32_t from = 0; from < groupCount; ++from)
+            {
+                const auto fromVertices = getGroupVertices(from);
+                if (std::empty(fromVertices))
+                    continue;
+
+                Collapse best{ from, Invalid, std::numeric_limits<double>::max() };
+                for (const uint32_t fromVertex : fromVertices)
+                {
+                    for (const uint32_t tri : adjacency.Get(fromVertex))
+                    {
+                        for (size_t k = 0; k < 3; ++k)
+                        {
+                            const uint32_t to = group[result[tri * 3 + k]];
+                            if (to == from || to == best.to)
+                                continue;
+
+                            // Border vertices may only slide along the border
+                            if (border[from] && (!border[to] || countSharedTriangles(from, to) != 1))
+                                continue;
+
+                            double attributeError = 0.0;
+                            bool valid = true;
+                            for (const uint32_t vertex : fromVertices)
+                            {
+                                const uint32_t target = findTarget(vertex, to);
+                                if (target == Invalid)
+                                {
+                                    valid = false;
+                                    break;
+                                }
+                                attributeError += AttributeDistance(vertices[vertex], vertices[target]);
+                            }
+
+                            if (!valid)
+                                continue;
+
+                            const Quadric& quadric = quadrics[from];
+                            const double cost = quadric.Evaluate(positions[groupLeader[to]]) +
+                                SimplifyAttributeWeight * attributeError * quadric.weight;
+                            if (cost < best.cost || (cost == best.cost && to < best.to))
+                                best = { from, to, cost };
+                        }
+                    }
+                }
+
+                if (best.to != Invalid)
+                    collapses.push_back(best);
+            }
+
+            std::sort(std::begin(collapses), std::end(collapses), [](const Collapse& a, const Collapse& b) {
+                if (a.cost != b.cost)
+                    return a.cost < b.cost;
+                return a.from != b.from ? a.from < b.from : a.to < b.to;
+            });
+
+            for (uint32_t v = 0; v < vertexCount; ++v)
+                remap[v] = v;
+            std::fill(std::begin(locked), std::end(locked), false);
+
+            const size_t removeGoal = std::size(result) / 3 - targetIndexCount / 3;
+            size_t removed = 0;
+            size_t applied = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (locked[collapse.from] || locked[collapse.to] || flipsTriangles(collapse))
+                    continue;
+
+                for (const uint32_t vertex : getGroupVertices(collapse.from))
+                {
+                    remap[vertex] = findTarget(vertex, collapse.to);
+
+                    // Everything around the collapse has changed so leave it for the next pass
+                    for (const uint32_t tri : adjacency.Get(vertex))
+                    {
+                        bool collapsing = false;
+                        for (size_t k = 0; k < 3; ++k)
+                        {
+                            locked[group[result[tri * 3 + k]]] = true;
+                            collapsing |= group[result[tri * 3 + k]] == collapse.to;
+                        }
+                        removed += collapsing ? 1 : 0;
+                    }
+                }
+
+                const Quadric& quadric = quadrics[collapse.from];
+                if (quadric.weight > 0.0)
+                    maxError = std::max(maxError, quadric.Evaluate(positions[groupLeader[collapse.to]]) / quadric.weight);
+                quadrics[collapse.to] += quadrics[collapse.from];
+
+                ++applied;
+                if (removed >= removeGoal)
+                    break;
+            }
+
+            if (applied == 0)
+                break;
+
+            for (uint32_t& index : result)
+                index = remap[index];
+
+            removeDegenerateTriangles();
+        }
+
+        resultError = float(std::sqrt(maxError)) * extent;
+        return result;
+    }
+
+    std::vector<Vertex> WeldVertices(std::vector<uint32_t>& indices, Span<const Vertex> vertices, float epsilon)
+    {
+        constexpr uint32_t Empty = std::numeric_limits<uint32_t>::max();
+
+        // Keys are compared and hashed as raw bytes, Vertex has no padding
+        std::vector<Vertex> keys(std::begin(vertices), std::end(vertices));
+        for (auto& key : keys)
+        {
+            if (epsilon > 0.0f)
+            {
+                key.pos = glm::round(key.pos / epsilon);
+                key.normal = glm::round(key.normal / epsilon);
+                key.color = glm::round(key.color / epsilon);
+                key.texCoord = glm::round(key.texCoord / epsilon);
+            }
+
+            // -0.0 and 0.0 have to produce the same bytes
+            key.pos += 0.0f;
+            key.normal += 0.0f;
+            key.color += 0.0f;
+            key.texCoord += 0.0f;
+        }
+
+        size_t capacity = 16;
+        while (capacity < std::size(vertices) * 2)
+            capacity *= 2;
+
+        // Linear probing over a power of two table, each slot holds the index of the kept vertex
+        std::vector<uint32_t> table(capacity, Empty);
+        std::vector<uint32_t> remap(std::size(vertices), Empty);
+        std::vector<Vertex> result;
+        result.reserve(std::size(vertices));
+
+        const auto findOrInsert = [&](uint32_t vertex) {
+            size_t slot = HashUtils::Hash64(&keys[vertex], sizeof(Vertex)) & (capacity - 1);
+            while (table[slot] != Empty)
+            {
+                if (memcmp(&keys[table[slot]], &keys[vertex], sizeof(Vertex)) == 0)
+                    return remap[table[slot]];
+                slot = (slot + 1) & (capacity - 1);
+            }
+
+            table[slot] = vertex;
+            remap[vertex] = (uint32_t)std::size(result);
+            result.push_back(vertices[vertex]);
+            return remap[vertex];
+        };
+
+        for (uint32_t& index : indices)
+        {
+            if (remap[index] == Empty)
+                remap[index] = findOrInsert(index);
+            index = remap[index];
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Span.h"
+#include "Vertex.h"
+#include "Meshlet.h"
+
+namespace MeshOptimizer
+{
+    struct VertexCacheStats
+    {
+        uint32_t vertexTransforms = 0;
+        // Average cache miss ratio, transformed vertices per triangle
+        float acmr = 0.0f;
+        // Average transform to vertex ratio, 1.0 is optimal
+        float atvr = 0.0f;
+    };
+
+    struct OverdrawStats
+    {
+        uint64_t pixelsCovered = 0;
+        uint64_t pixelsShaded = 0;
+        // Shaded fragments per covered pixel, 1.0 is optimal
+        float overdraw = 0.0f;
+    };
+
+    struct VertexFetchStats
+    {
+        uint64_t bytesFetched = 0;
+        // Fetched bytes per byte of referenced vertex data, 1.0 is optimal
+        float overfetch = 0.0f;
+    };
+
+    struct MeshletData
+    {
+        std::vector<Meshlet> meshlets;
+        // Mesh vertex index for each meshlet vertex
+        std::vector<uint32_t> vertices;
+        // Three meshlet local indices per triangle, each meshlet padded to 4 bytes
+        std::vector<uint8_t> triangles;
+    };
+
+    // Simulates a FIFO post-transform cache of the given size
+    VertexCacheStats AnalyzeVertexCache(Span<const uint32_t> indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+    // Reorders the triangles of an indexed triangle list for the post-transform vertex cache
+    // using Tom Forsyth's linear-speed vertex cache optimisation.
+    void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+    // Rasterizes the mesh in index order from the six axis directions with depth testing
+    // and back-face culling, measuring how often covered pixels get shaded.
+    OverdrawStats AnalyzeOverdraw(Span<const uint32_t> indices, Span<const Vertex> vertices);
+
+    // Splits the (vertex cache optimized) triangle order into clusters and sorts the clusters
+    // so that outward facing geometry is drawn first. Clusters are split further as long as
+    // their ACMR stays below threshold times the ACMR of the input, so a higher threshold
+    // gives up vertex cache efficiency for less overdraw.
+    void OptimizeOverdraw(std::vector<uint32_t>& indices, Span<const Vertex> vertices, float threshold = 1.05f);
+
+    // Simulates a 16KB vertex fetch cache with 64 byte lines
+    VertexFetchStats AnalyzeVertexFetch(Span<const uint32_t> indices, size_t vertexCount, size_t vertexSize);
+
+    // Reorders the vertices in the order they are first referenced by the index buffer and
+    // remaps the indices to match. Unreferenced vertices are dropped.
+    std::vector<Vertex> OptimizeVertexFetch(std::vector<uint32_t>& indices, Span<const Vertex> vertices);
+
+    // Splits the triangles into meshlets in index order, so run it on a vertex cache
+    // optimized index buffer to get tightly packed clusters.
+    MeshletData BuildMeshlets(Span<const uint32_t> indices, Span<const Vertex> vertices);
+
+    // Quadric error edge collapse that only moves vertices onto existing vertices, so the result
+    // shares the vertex buffer. Collapses are weighted by normal, color and UV differences,
+    // vertices on UV/normal seams collapse together and open borders only collapse along the
+    // border. Returns the new index buffer and the largest collapse error in mesh units.
+    std::vector<uint32_t> Simplify(Span<const uint32_t> indices, Span<const Vertex> vertices,
+        size_t targetIndexCount, float& resultError);
+
+    // Merges duplicate vertices using a flat open addressing hash table and remaps the indices.
+    // With a non-zero epsilon every attribute is snapped to a grid of that size before comparing,
+    // so nearly equal vertices merge too. The first vertex of each group is kept unmodified.
+    std::vector<Vertex> WeldVertices(std::vector<uint32_t>& indices, Span<const Vertex> vertices, float epsilon = 0.0f);
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+// A cluster of up to MaxVertices vertices and MaxTriangles triangles. The triangles use
+// 8-bit indices into the meshlet's vertex list, which in turn indexes the mesh vertices.
+struct Meshlet
+{
+    static constexpr uint32_t MaxVertices = 64;
+    static constexpr uint32_t MaxTriangles = 124;
+
+    // Offsets into the mesh's meshlet vertex and meshlet triangle arrays
+    uint32_t vertexOffset = 0;
+    uint32_t triangleOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+
+    glm::vec3 center{ 0.0f };
+    float radius = 0.0f;
+
+    // Normal cone, coneCutoff is 1 when the triangles face too many ways to be culled
+    glm::vec3 coneAxis{ 0.0f };
+    float coneCutoff = 1.0f;
+
+    bool IsBackfacing(const glm::vec3& viewPos) const
+    {
+        const glm::vec3 toCenter = center - viewPos;
+        return glm::dot(toCenter, coneAxis) >= coneCutoff * glm::length(toCenter) + radius;
+    }
+};
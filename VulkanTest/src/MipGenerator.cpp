@@ -0,0 +1,217 @@
+#include "MipGenerator.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define MIP_GENERATOR_SSE 1
+#   include <emmintrin.h>
+#else
+#   define MIP_GENERATOR_SSE 0
+#endif
+
+// The AVX2 kernel is built on every x64 target and picked at runtime, the project doesn't require AVX2
+#if defined(_M_X64) || defined(__x86_64__)
+#   define MIP_GENERATOR_AVX2 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       include <intrin.h>
+#       define MIP_GENERATOR_AVX2_TARGET
+#   else
+#       define MIP_GENERATOR_AVX2_TARGET __attribute__((target("avx2")))
+#   endif
+#else
+#   define MIP_GENERATOR_AVX2 0
+#endif
+
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace MipGenerator
+{
+    namespace
+    {
+        constexpr uint32_t BytesPerPixel = 4;
+        // Destination rows per pool job, smaller levels are filtered on the calling thread
+        constexpr uint32_t RowsPerJob = 16;
+
+        // Linear values are kept as 16-bit fixed point, fine enough that every sRGB value survives the round trip
+        struct SrgbTables
+        {
+            int32_t toLinear[256];
+            // Padded so a 32-bit gather at the last entry stays inside the table
+            uint8_t fromLinear[65536 + 3];
+        };
+
+        const SrgbTables& GetSrgbTables()
+        {
+            static const SrgbTables tables = []() {
+                SrgbTables t{};
+                for (int i = 0; i < 256; ++i)
+                {
+                    const double s = i / 255.0;
+                    const double linear = s <= 0.04045 ? s / 12.92 : std::pow((s + 0.055) / 1.055, 2.4);
+                    t.toLinear[i] = (int32_t)std::lround(linear * 65535.0);
+                }
+                for (int i = 0; i < 65536; ++i)
+                {
+                    const double linear = i / 65535.0;
+                    const double s = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+                    t.fromLinear[i] = (uint8_t)std::lround(s * 255.0);
+                }
+                return t;
+            }();
+            return tables;
+        }
+
+        // Scalar filters for one destination pixel, also handle single pixel wide sources
+        void DownsamplePixelLinear(const uint8_t* row0, const uint8_t* row1, uint32_t srcWidth, uint32_t x, uint8_t* out)
+        {
+            const size_t x0 = size_t(std::min(x * 2, srcWidth - 1)) * BytesPerPixel;
+            const size_t x1 = size_t(std::min(x * 2 + 1, srcWidth - 1)) * BytesPerPixel;
+            for (uint32_t c = 0; c < BytesPerPixel; ++c)
+                out[c] = uint8_t((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+        }
+
+        void DownsamplePixelSrgb(const uint8_t* row0, const uint8_t* row1, uint32_t srcWidth, uint32_t x, uint8_t* out, const SrgbTables& tables)
+        {
+            const size_t x0 = size_t(std::min(x * 2, srcWidth - 1)) * BytesPerPixel;
+            const size_t x1 = size_t(std::min(x * 2 + 1, srcWidth - 1)) * BytesPerPixel;
+            const int32_t* toLinear = tables.toLinear;
+            for (uint32_t c = 0; c < 3; ++c)
+            {
+                const int32_t sum = toLinear[row0[x0 + c]] + toLinear[row0[x1 + c]] + toLinear[row1[x0 + c]] + toLinear[row1[x1 + c]];
+                out[c] = tables.fromLinear[(sum + 2) >> 2];
+            }
+            out[3] = uint8_t((row0[x0 + 3] + row0[x1 + 3] + row1[x0 + 3] + row1[x1 + 3] + 2) / 4);
+        }
+
+        void DownsampleRowLinear(const uint8_t* row0, const uint8_t* row1, uint32_t srcWidth, uint8_t* dst, uint32_t dstWidth)
+        {
+            uint32_t x = 0;
+#if MIP_GENERATOR_SSE
+            // Two destination pixels from four source pixels of each row, needs both source pixels of every pair
+            if (srcWidth >= 2)
+            {
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i two = _mm_set1_epi16(2);
+                for (; x + 2 <= dstWidth; x += 2)
+                {
+                    const __m128i r0 = _mm_loadu_si128((const __m128i*)(row0 + x * 2 * BytesPerPixel));
+                    const __m128i r1 = _mm_loadu_si128((const __m128i*)(row1 + x * 2 * BytesPerPixel));
+                    const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(r0, zero), _mm_unpacklo_epi8(r1, zero));
+                    const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(r0, zero), _mm_unpackhi_epi8(r1, zero));
+                    const __m128i sum = _mm_add_epi16(_mm_unpacklo_epi64(lo, hi), _mm_unpackhi_epi64(lo, hi));
+                    const __m128i avg = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+                    _mm_storel_epi64((__m128i*)(dst + x * BytesPerPixel), _mm_packus_epi16(avg, avg));
+                }
+            }
+#endif
+            for (; x < dstWidth; ++x)
+                DownsamplePixelLinear(row0, row1, srcWidth, x, dst + x * BytesPerPixel);
+        }
+
+#if MIP_GENERATOR_AVX2
+        bool HasAvx2()
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+
+            // The OS has to save the YMM registers as well
+            __cpuid(info, 1);
+            const bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+            __cpuidex(info, 7, 0);
+            return osAvx && (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+        // Two destination pixels per step, the table lookups are gathers and alpha takes the plain average.
+        // Returns how many destination pixels were filtered, needs both source pixels of every pair
+        MIP_GENERATOR_AVX2_TARGET uint32_t DownsampleRowSrgbAvx2(const uint8_t* row0, const uint8_t* row1, uint8_t* dst, uint32_t dstWidth, const SrgbTables& tables)
+        {
+            uint32_t x = 0;
+            const __m256i two = _mm256_set1_epi32(2);
+            const __m256i byteMask = _mm256_set1_epi32(0xff);
+            const __m256i alphaMask = _mm256_setr_epi32(0, 0, 0, -1, 0, 0, 0, -1);
+            for (; x + 2 <= dstWidth; x += 2)
+            {
+                const uint8_t* src0 = row0 + x * 2 * BytesPerPixel;
+                const uint8_t* src1 = row1 + x * 2 * BytesPerPixel;
+                const __m256i a0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src0));
+                const __m256i a1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src0 + 8)));
+                const __m256i b0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)src1));
+                const __m256i b1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(src1 + 8)));
+
+                const __m256i linear0 = _mm256_add_epi32(_mm256_i32gather_epi32(tables.toLinear, a0, 4), _mm256_i32gather_epi32(tables.toLinear, b0, 4));
+                const __m256i linear1 = _mm256_add_epi32(_mm256_i32gather_epi32(tables.toLinear, a1, 4), _mm256_i32gather_epi32(tables.toLinear, b1, 4));
+                const __m256i raw0 = _mm256_add_epi32(a0, b0);
+                const __m256i raw1 = _mm256_add_epi32(a1, b1);
+
+                // Each vector holds a horizontal pair in its two halves, adding the halves gives one destination pixel
+                const __m256i linearSum = _mm256_add_epi32(_mm256_permute2x128_si256(linear0, linear1, 0x20), _mm256_permute2x128_si256(linear0, linear1, 0x31));
+                const __m256i rawSum = _mm256_add_epi32(_mm256_permute2x128_si256(raw0, raw1, 0x20), _mm256_permute2x128_si256(raw0, raw1, 0x31));
+
+                const __m256i linearAvg = _mm256_srli_epi32(_mm256_add_epi32(linearSum, two), 2);
+                const __m256i color = _mm256_and_si256(_mm256_i32gather_epi32((const int*)tables.fromLinear, linearAvg, 1), byteMask);
+                const __m256i alpha = _mm256_srli_epi32(_mm256_add_epi32(rawSum, two), 2);
+                const __m256i result = _mm256_blendv_epi8(color, alpha, alphaMask);
+
+                const __m256i packed16 = _mm256_packus_epi32(result, result);
+                const __m256i packed8 = _mm256_packus_epi16(packed16, packed16);
+                const int pixel0 = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed8));
+                const int pixel1 = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed8, 1));
+                memcpy(dst + x * BytesPerPixel, &pixel0, BytesPerPixel);
+                memcpy(dst + (x + 1) * BytesPerPixel, &pixel1, BytesPerPixel);
+            }
+            return x;
+        }
+#endif
+
+        void DownsampleRowSrgb(const uint8_t* row0, const uint8_t* row1, uint32_t srcWidth, uint8_t* dst, uint32_t dstWidth, const SrgbTables& tables)
+        {
+            uint32_t x = 0;
+#if MIP_GENERATOR_AVX2
+            static const bool hasAvx2 = HasAvx2();
+            if (hasAvx2 && srcWidth >= 2)
+                x = DownsampleRowSrgbAvx2(row0, row1, dst, dstWidth, tables);
+#endif
+            for (; x < dstWidth; ++x)
+                DownsamplePixelSrgb(row0, row1, srcWidth, x, dst + x * BytesPerPixel, tables);
+        }
+    }
+
+    void Downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight, bool srgb)
+    {
+        const SrgbTables* tables = srgb ? &GetSrgbTables() : nullptr;
+
+        const auto downsampleRows = [&](uint32_t firstRow, uint32_t lastRow) {
+            for (uint32_t y = firstRow; y < lastRow; ++y)
+            {
+                const uint8_t* row0 = src + size_t(std::min(y * 2, srcHeight - 1)) * srcWidth * BytesPerPixel;
+                const uint8_t* row1 = src + size_t(std::min(y * 2 + 1, srcHeight - 1)) * srcWidth * BytesPerPixel;
+                uint8_t* out = dst + size_t(y) * dstWidth * BytesPerPixel;
+                if (tables)
+                    DownsampleRowSrgb(row0, row1, srcWidth, out, dstWidth, *tables);
+                else
+                    DownsampleRowLinear(row0, row1, srcWidth, out, dstWidth);
+            }
+        };
+
+        const uint32_t jobCount = (dstHeight + RowsPerJob - 1) / RowsPerJob;
+        if (jobCount <= 1)
+        {
+            downsampleRows(0, dstHeight);
+            return;
+        }
+
+        ThreadPool::Get().ParallelFor(jobCount, [&](size_t job) {
+            const uint32_t firstRow = uint32_t(job) * RowsPerJob;
+            downsampleRows(firstRow, std::min(firstRow + RowsPerJob, dstHeight));
+        });
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// CPU mip generation for RGBA8 images, for formats the GPU can't blit and so sRGB levels are
+// filtered in linear space. Uses AVX2 gathers for sRGB levels on CPUs that have AVX2, SSE2 for
+// the linear filter and plain C++ everywhere else.
+namespace MipGenerator
+{
+    // Halves a level with a 2x2 box filter, the last row or column of an odd sized source is dropped.
+    // With srgb the color channels are converted to linear before averaging and back after, alpha is
+    // always averaged as is. Large levels are filtered in parallel on the thread pool.
+    void Downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth, uint32_t dstHeight, bool srgb);
+}
@@ -1,44 +1,252 @@
 #include "Model.h"
 
 #include "Log.h"
+#include "MeshCache.h"
+#include "BinaryIO.h"
+#include "HashUtils.h"
+#include "ThreadPool.h"
+#include "GltfLoader.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
-std::unique_ptr<Model> Model::Load(const std::filesystem::path& filepath)
+#include <glm/gtc/type_ptr.hpp>
+
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+
+uint64_t ModelLoadOptions::GetProcessingHash() const
+{
+    BinaryWriter writer;
+    writer.Write(weldVertices);
+    writer.Write(weldEpsilon);
+    writer.Write(optimizeVertexCache);
+    writer.Write(optimizeOverdraw);
+    writer.Write(overdrawThreshold);
+    writer.Write(optimizeVertexFetch);
+    writer.Write(buildMeshlets);
+    writer.Write(lodCount);
+    writer.Write(lodRatio);
+
+    const auto& buffer = writer.GetBuffer();
+    return HashUtils::Hash64(std::data(buffer), std::size(buffer));
+}
+
+bool ModelLoadOptions::HasProcessing() const
+{
+    return weldVertices || optimizeVertexCache || optimizeOverdraw || optimizeVertexFetch || lodCount > 1 || buildMeshlets;
+}
+
+namespace
+{
+    bool IsGlb(const std::filesystem::path& filepath)
+    {
+        auto extension = filepath.extension().string();
+        std::transform(std::begin(extension), std::end(extension), std::begin(extension), [](char c) { return (char)std::tolower((unsigned char)c); });
+        return extension == ".glb";
+    }
+
+    void ProcessMesh(Mesh& mesh, const ModelLoadOptions& options)
+    {
+        if (options.weldVertices)
+            mesh.WeldVertices(options.weldEpsilon);
+        if (options.optimizeVertexCache)
+            mesh.OptimizeVertexCache();
+        if (options.optimizeOverdraw)
+            mesh.OptimizeOverdraw(options.overdrawThreshold);
+        if (options.optimizeVertexFetch)
+            mesh.OptimizeVertexFetch();
+        if (options.lodCount > 1)
+            mesh.BuildLods(options.lodCount, options.lodRatio);
+        if (options.buildMeshlets)
+            mesh.BuildMeshlets();
+    }
+}
+
+std::unique_ptr<Model> Model::Load(const std::filesystem::path& filepath, const ModelLoadOptions& options)
+{
+    const bool isGlb = IsGlb(filepath);
+
+    // An unprocessed binary glTF is mapped and used in place, which is as fast as the mesh cache without hashing the source
+    const bool useCache = options.useCache && !(isGlb && !options.HasProcessing());
+    if (useCache)
+    {
+        if (auto cachedModel = MeshCache::Load(filepath, options))
+            return cachedModel;
+    }
+
+    std::unique_ptr<Model> loadedModel;
+    if (isGlb)
+        loadedModel = GltfLoader::Load(filepath);
+    if (!loadedModel)
+        loadedModel = Import(filepath, options);
+    if (!loadedModel)
+        return {};
+
+    // Meshes are processed independently, each in its own slot, so the output is the same
+    // as processing them in order
+    if (options.HasProcessing())
+    {
+        ThreadPool::Get().ParallelFor(std::size(loadedModel->mMeshs), [&](size_t i) {
+            ProcessMesh(*loadedModel->mMeshs[i], options);
+        });
+    }
+
+    loadedModel->UpdateBounds();
+
+    if (useCache)
+        MeshCache::Write(filepath, options, *loadedModel);
+
+    return loadedModel;
+}
+
+std::unique_ptr<Model> Model::ImportEach(const std::filesystem::path& filepath, const ModelLoadOptions& options, const MeshCallback& onMesh)
+{
+    // A binary glTF is mapped, its meshes only take up memory once processing copies them
+    std::unique_ptr<Model> loadedModel;
+    if (IsGlb(filepath))
+        loadedModel = GltfLoader::Load(filepath);
+    if (!loadedModel)
+        return Import(filepath, options, onMesh);
+
+    std::vector<Bounds> meshBounds(std::size(loadedModel->mMeshs));
+    for (uint32_t i = 0; i < std::size(loadedModel->mMeshs); ++i)
+    {
+        auto& mesh = loadedModel->mMeshs[i];
+        ProcessMesh(*mesh, options);
+        meshBounds[i] = mesh->GetBounds();
+        onMesh(i, *mesh);
+        mesh.reset();
+    }
+    loadedModel->mMeshs.clear();
+    loadedModel->UpdateBounds(meshBounds);
+
+    return loadedModel;
+}
+
+std::unique_ptr<Model> Model::Import(const std::filesystem::path& filepath, const ModelLoadOptions& options, const MeshCallback& onMesh)
 {
-    constexpr uint32_t flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices;
+    uint32_t flags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs;
+    if (!options.weldVertices)
+        flags |= aiProcess_JoinIdenticalVertices;
 
     Assimp::Importer importer;
-    const aiScene* const scene = importer.ReadFile(filepath.string(), flags);
-    if (!scene)
+    if (!importer.ReadFile(filepath.string(), flags))
     {
         LOG_ERROR("Failed to load mesh {0}: {1}", filepath.string(), importer.GetErrorString());
         return {};
     }
 
+    // Owned here so source meshes can be freed as they are converted
+    const std::unique_ptr<aiScene> scene(importer.GetOrphanedScene());
+
     auto loadedModel = std::make_unique<Model>();
     loadedModel->mName = scene->mName.C_Str();
 
-    loadedModel->mMeshs.reserve(scene->mNumMeshes);
-    for (uint32_t i = 0; i < scene->mNumMeshes; ++i)
+    std::vector<Bounds> meshBounds;
+    if (onMesh)
     {
-        loadedModel->mMeshs.emplace_back(Mesh::Load(scene->mMeshes[i]));
+        meshBounds.resize(scene->mNumMeshes);
+        for (uint32_t i = 0; i < scene->mNumMeshes; ++i)
+        {
+            auto mesh = Mesh::Load(scene->mMeshes[i]);
+            delete scene->mMeshes[i];
+            scene->mMeshes[i] = nullptr;
+
+            ProcessMesh(*mesh, options);
+            meshBounds[i] = mesh->GetBounds();
+            onMesh(i, *mesh);
+        }
+    }
+    else
+    {
+        loadedModel->mMeshs.resize(scene->mNumMeshes);
+        ThreadPool::Get().ParallelFor(scene->mNumMeshes, [&](size_t i) {
+            loadedModel->mMeshs[i] = Mesh::Load(scene->mMeshes[i]);
+        });
+    }
+
+    // Depth first with an explicit stack, a node is always added before its children
+    std::vector<std::pair<const aiNode*, uint32_t>> nodeStack;
+    if (scene->mRootNode)
+        nodeStack.emplace_back(scene->mRootNode, NodeHierarchy::NoParent);
+    while (!std::empty(nodeStack))
+    {
+        const auto [node, parent] = nodeStack.back();
+        nodeStack.pop_back();
+
+        // Assimp matrices are row major
+        const glm::mat4 localTransform = glm::transpose(glm::make_mat4(&node->mTransformation.a1));
+        const uint32_t nodeIndex = loadedModel->mNodes.AddNode(parent, localTransform);
+        for (uint32_t i = 0; i < node->mNumMeshes; ++i)
+            loadedModel->mInstances.push_back({ node->mMeshes[i], nodeIndex });
+
+        for (uint32_t i = node->mNumChildren; i > 0; --i)
+            nodeStack.emplace_back(node->mChildren[i - 1], nodeIndex);
     }
 
+    // Materials refer to textures by index so a file used by several materials is only loaded once
+    std::unordered_map<std::string, uint32_t> textureIndices;
+    loadedModel->mMaterials.resize(scene->mNumMaterials);
     for (uint32_t i = 0; i < scene->mNumMaterials; ++i)
     {
         const aiMaterial* const material = scene->mMaterials[i];
-        if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0)
+        auto& loadedMaterial = loadedModel->mMaterials[i];
+        loadedMaterial.name = material->GetName().C_Str();
+
+        aiString path;
+        if (material->GetTextureCount(aiTextureType_DIFFUSE) > 0 &&
+            material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == aiReturn_SUCCESS)
         {
-            aiString path;
-            if (material->GetTexture(aiTextureType_DIFFUSE, 0, &path) == aiReturn_SUCCESS)
-            {
-                loadedModel->mDiffuseTextureName = "assets/textures/" + std::filesystem::path(path.C_Str()).filename().string();
-            }
+            const auto texturePath = "assets/textures/" + std::filesystem::path(path.C_Str()).filename().string();
+            const auto [it, inserted] = textureIndices.try_emplace(texturePath, (uint32_t)std::size(loadedModel->mTexturePaths));
+            if (inserted)
+                loadedModel->mTexturePaths.push_back(texturePath);
+            loadedMaterial.diffuseTexture = it->second;
         }
     }
 
+    if (onMesh)
+        loadedModel->UpdateBounds(meshBounds);
+
     return loadedModel;
 }
+
+void Model::UpdateBounds()
+{
+    std::vector<Bounds> meshBounds;
+    for (const auto& mesh : mMeshs)
+        meshBounds.push_back(mesh->GetBounds());
+    UpdateBounds(meshBounds);
+}
+
+void Model::UpdateBounds(const std::vector<Bounds>& meshBounds)
+{
+    mBounds = {};
+    const auto& worldTransforms = mNodes.GetWorldTransforms();
+    for (size_t i = 0; i < std::size(mInstances); ++i)
+    {
+        const auto& instance = mInstances[i];
+        const Bounds bounds = meshBounds[instance.meshIndex].Transform(worldTransforms[instance.nodeIndex]);
+        mBounds = i == 0 ? bounds : Bounds::Merge(mBounds, bounds);
+    }
+}
+
+std::vector<std::unique_ptr<Model>> Model::LoadMany(const std::vector<std::filesystem::path>& filepaths, const ModelLoadOptions& options)
+{
+    std::vector<std::unique_ptr<Model>> models(std::size(filepaths));
+    ThreadPool::Get().ParallelFor(std::size(filepaths), [&](size_t i) {
+        models[i] = Load(filepaths[i], options);
+    });
+
+    return models;
+}
+
+std::future<std::unique_ptr<Model>> Model::LoadAsync(const std::filesystem::path& filepath, const ModelLoadOptions& options)
+{
+    return ThreadPool::Get().Submit([filepath, options]() {
+        return Load(filepath, options);
+    });
+}
@@ -4,8 +4,54 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <future>
+#include <functional>
 
 #include "Mesh.h"
+#include "Material.h"
+#include "NodeHierarchy.h"
+#include "MappedFile.h"
+
+struct ModelLoadOptions
+{
+    // Read from and write to the binary mesh cache next to the source asset
+    bool useCache = true;
+    // Store vertex and index data compressed when writing the cache. Smaller files, but meshes are
+    // decoded into memory on load instead of being used in place from the mapped cache.
+    bool compressCache = false;
+
+    // Merge duplicate vertices ourselves instead of using Assimp's JoinIdenticalVertices, runs first.
+    // A non-zero epsilon also merges vertices whose attributes fall in the same epsilon sized cell.
+    bool weldVertices = false;
+    float weldEpsilon = 0.0f;
+
+    // Reorder triangles for the post-transform vertex cache
+    bool optimizeVertexCache = false;
+
+    // Sort triangle clusters to reduce overdraw, runs after the vertex cache optimization.
+    // The threshold is the ACMR increase allowed for finer clusters, e.g. 1.05 allows 5%.
+    bool optimizeOverdraw = false;
+    float overdrawThreshold = 1.05f;
+
+    // Reorder vertices to match their first use in the index buffer, runs after the overdraw pass
+    bool optimizeVertexFetch = false;
+
+    // Number of detail levels including the full mesh, each with lodRatio of the previous level's triangles
+    uint32_t lodCount = 1;
+    float lodRatio = 0.5f;
+
+    // Split each mesh into meshlets with culling bounds
+    bool buildMeshlets = false;
+
+    // Decode a compressed cache this many more times after loading it and log the throughput,
+    // for measuring the codec on real meshes. Doesn't change the processed mesh data
+    uint32_t decodeBenchRuns = 0;
+
+    // Hash of every option that changes the processed mesh data
+    uint64_t GetProcessingHash() const;
+    // Whether any of the processing passes run, without them meshes are used as imported
+    bool HasProcessing() const;
+};
 
 class Model
 {
@@ -15,13 +61,55 @@ public:
     const std::string& GetName() const { return mName; }
     const std::vector<std::unique_ptr<Mesh>>& GetMeshes() const { return mMeshs; }
 
-    const std::string& GetDiffuseTextureName() const { return mDiffuseTextureName; }
+    // Nodes of the source file and the meshes placed at them, a mesh is only drawn through its instances
+    const NodeHierarchy& GetNodes() const { return mNodes; }
+    const std::vector<MeshInstance>& GetInstances() const { return mInstances; }
 
-    static std::unique_ptr<Model> Load(const std::filesystem::path& filepath);
+    // Bounds of every mesh instance together, in the space of the root node's parent
+    const Bounds& GetBounds() const { return mBounds; }
+
+    const std::vector<Material>& GetMaterials() const { return mMaterials; }
+    // Every texture file referenced by the materials, each listed once
+    const std::vector<std::string>& GetTexturePaths() const { return mTexturePaths; }
+
+    static std::unique_ptr<Model> Load(const std::filesystem::path& filepath, const ModelLoadOptions& options = {});
+
+    // Loads the files in parallel, failed loads are left null
+    static std::vector<std::unique_ptr<Model>> LoadMany(const std::vector<std::filesystem::path>& filepaths,
+        const ModelLoadOptions& options = {});
+
+    // Runs Load on the shared thread pool, the future holds null if the load failed
+    static std::future<std::unique_ptr<Model>> LoadAsync(const std::filesystem::path& filepath,
+        const ModelLoadOptions& options = {});
+
+    // Reads the file one mesh at a time for building other formats without holding every mesh. Each mesh
+    // is processed, passed to onMesh in order and freed, so the returned model has no meshes. Skips the mesh cache.
+    using MeshCallback = std::function<void(uint32_t meshIndex, const Mesh& mesh)>;
+    static std::unique_ptr<Model> ImportEach(const std::filesystem::path& filepath, const ModelLoadOptions& options,
+        const MeshCallback& onMesh);
 
 private:
+    // Reads the file through Assimp without any of the processing passes. With onMesh the meshes are
+    // converted, processed and handed over one at a time instead, see ImportEach
+    static std::unique_ptr<Model> Import(const std::filesystem::path& filepath, const ModelLoadOptions& options,
+        const MeshCallback& onMesh = {});
+
+    void UpdateBounds();
+    void UpdateBounds(const std::vector<Bounds>& meshBounds);
+
+private:
+    friend class MeshCache;
+    friend class GltfLoader;
+
     std::string mName;
     std::vector<std::unique_ptr<Mesh>> mMeshs;
+    NodeHierarchy mNodes;
+    std::vector<MeshInstance> mInstances;
+
+    std::vector<Material> mMaterials;
+    std::vector<std::string> mTexturePaths;
+    Bounds mBounds;
 
-    std::string mDiffuseTextureName;
+    // Backing memory for meshes that point into a mapped mesh cache or glTF binary
+    std::unique_ptr<MappedFile> mMappedFile;
 };
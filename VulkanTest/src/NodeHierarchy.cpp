@@ -0,0 +1,24 @@
+#include "NodeHierarchy.h"
+
+#include <stdexcept>
+
+uint32_t NodeHierarchy::AddNode(uint32_t parent, const glm::mat4& localTransform)
+{
+    const uint32_t node = GetNodeCount();
+    if (parent != NoParent && parent >= node)
+        throw std::runtime_error("Node parent has to be added before its children");
+
+    mParents.push_back(parent);
+    mLocalTransforms.push_back(localTransform);
+    mWorldTransforms.push_back(parent == NoParent ? localTransform : mWorldTransforms[parent] * localTransform);
+    return node;
+}
+
+void NodeHierarchy::UpdateWorldTransforms()
+{
+    for (size_t i = 0; i < std::size(mParents); ++i)
+    {
+        const uint32_t parent = mParents[i];
+        mWorldTransforms[i] = parent == NoParent ? mLocalTransforms[i] : mWorldTransforms[parent] * mLocalTransforms[i];
+    }
+}
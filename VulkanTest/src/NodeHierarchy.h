@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Node tree stored as flat arrays where every parent comes before its children,
+// so world transforms update in one pass from front to back without following pointers
+class NodeHierarchy
+{
+public:
+    static constexpr uint32_t NoParent = ~0u;
+
+    NodeHierarchy() = default;
+
+    uint32_t GetNodeCount() const { return (uint32_t)std::size(mParents); }
+    const std::vector<uint32_t>& GetParents() const { return mParents; }
+    const std::vector<glm::mat4>& GetLocalTransforms() const { return mLocalTransforms; }
+    const std::vector<glm::mat4>& GetWorldTransforms() const { return mWorldTransforms; }
+
+    // The parent has to be added first. Returns the index of the new node, its world transform is set right away.
+    uint32_t AddNode(uint32_t parent, const glm::mat4& localTransform);
+
+    // World transforms are stale until UpdateWorldTransforms is called
+    void SetLocalTransform(uint32_t node, const glm::mat4& localTransform) { mLocalTransforms[node] = localTransform; }
+    void UpdateWorldTransforms();
+
+private:
+    std::vector<uint32_t> mParents;
+    std::vector<glm::mat4> mLocalTransforms;
+    std::vector<glm::mat4> mWorldTransforms;
+};
+
+// A mesh placed at a node, meshes placed by several nodes share one copy of their geometry
+struct MeshInstance
+{
+    uint32_t meshIndex = 0;
+    uint32_t nodeIndex = 0;
+};
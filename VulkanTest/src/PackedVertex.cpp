@@ -0,0 +1,92 @@
+#include "PackedVertex.h"
+
+#include <glm/gtc/packing.hpp>
+
+namespace
+{
+    glm::vec2 OctahedralEncode(const glm::vec3& n)
+    {
+        const float length = glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+        if (length == 0.0f)
+            return glm::vec2(0.0f);
+
+        glm::vec2 result = glm::vec2(n) / length;
+        if (n.z < 0.0f)
+        {
+            result = (1.0f - glm::abs(glm::vec2(result.y, result.x))) *
+                glm::vec2(result.x >= 0.0f ? 1.0f : -1.0f, result.y >= 0.0f ? 1.0f : -1.0f);
+        }
+
+        return result;
+    }
+}
+
+PackedVertex PackedVertex::Pack(const Vertex& vertex, const PositionQuantization& quantization)
+{
+    PackedVertex packed{};
+
+    const glm::vec3 pos = (vertex.pos - quantization.offset) / quantization.scale;
+    for (int i = 0; i < 3; ++i)
+        packed.pos[i] = glm::packUnorm1x16(pos[i]);
+    packed.pos[3] = 0xffff;
+
+    const glm::vec2 normal = OctahedralEncode(vertex.normal);
+    packed.normal[0] = (int16_t)glm::packSnorm1x16(normal.x);
+    packed.normal[1] = (int16_t)glm::packSnorm1x16(normal.y);
+
+    for (int i = 0; i < 3; ++i)
+        packed.color[i] = glm::packUnorm1x8(vertex.color[i]);
+    packed.color[3] = 0xff;
+
+    packed.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+    packed.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+
+    return packed;
+}
+
+PositionQuantization PackedVertex::ComputePositionQuantization(const Bounds& bounds)
+{
+    PositionQuantization quantization;
+    quantization.offset = bounds.min;
+    // Flat axes still need a non-zero scale to avoid dividing by zero when packing
+    quantization.scale = glm::max(bounds.max - bounds.min, glm::vec3(1e-20f));
+    return quantization;
+}
+
+std::array<VkVertexInputBindingDescription, 1> PackedVertex::GetBindingDescriptions()
+{
+    std::array<VkVertexInputBindingDescription, 1> bindingDescs{};
+
+    bindingDescs[0].binding = 0;
+    bindingDescs[0].stride = sizeof(PackedVertex);
+    bindingDescs[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    return bindingDescs;
+}
+
+std::array<VkVertexInputAttributeDescription, 4> PackedVertex::GetAttributeDescriptions()
+{
+    std::array<VkVertexInputAttributeDescription, 4> attrDescs{};
+
+    attrDescs[0].binding = 0;
+    attrDescs[0].location = 0;
+    attrDescs[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+    attrDescs[0].offset = offsetof(PackedVertex, pos);
+
+    attrDescs[1].binding = 0;
+    attrDescs[1].location = 1;
+    attrDescs[1].format = VK_FORMAT_R16G16_SNORM;
+    attrDescs[1].offset = offsetof(PackedVertex, normal);
+
+    attrDescs[2].binding = 0;
+    attrDescs[2].location = 2;
+    attrDescs[2].format = VK_FORMAT_R8G8B8A8_UNORM;
+    attrDescs[2].offset = offsetof(PackedVertex, color);
+
+    attrDescs[3].binding = 0;
+    attrDescs[3].location = 3;
+    attrDescs[3].format = VK_FORMAT_R16G16_SFLOAT;
+    attrDescs[3].offset = offsetof(PackedVertex, texCoord);
+
+    return attrDescs;
+}
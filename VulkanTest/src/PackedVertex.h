@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.h"
+#include "Bounds.h"
+
+enum class VertexFormat
+{
+    Float,
+    Packed
+};
+
+// Maps 16-bit unorm positions back into model space: pos = quantized * scale + offset
+struct PositionQuantization
+{
+    glm::vec3 offset{ 0.0f };
+    glm::vec3 scale{ 1.0f };
+};
+
+// 20 byte vertex: positions normalized to the mesh bounds, octahedral normals,
+// 8-bit color and half float texture coordinates.
+struct PackedVertex
+{
+    uint16_t pos[4];
+    int16_t normal[2];
+    uint8_t color[4];
+    uint16_t texCoord[2];
+
+    static PackedVertex Pack(const Vertex& vertex, const PositionQuantization& quantization);
+    static PositionQuantization ComputePositionQuantization(const Bounds& bounds);
+
+    static std::array<VkVertexInputBindingDescription, 1> GetBindingDescriptions();
+
+    static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions();
+};
@@ -0,0 +1,78 @@
+#include "PageCache.h"
+
+#include "PagedModel.h"
+#include "ThreadPool.h"
+
+PageCache::PageCache(const PagedModel& model, size_t memoryLimit) :
+    mModel(model),
+    mMemoryLimit(memoryLimit)
+{
+}
+
+std::shared_ptr<const GeometryPage> PageCache::Request(uint32_t pageIndex)
+{
+    if (auto it = mEntries.find(pageIndex); it != std::end(mEntries))
+    {
+        Entry& entry = it->second;
+        if (entry.pending.valid())
+        {
+            if (entry.pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                return {};
+
+            --mPendingReads;
+            auto page = entry.pending.get();
+            if (!page)
+            {
+                mMemoryUsage -= entry.size;
+                entry.size = 0;
+                entry.failed = true;
+                return {};
+            }
+
+            entry.page = std::move(page);
+            mLru.push_front(pageIndex);
+            entry.lruPos = std::begin(mLru);
+            return entry.page;
+        }
+
+        if (entry.failed)
+            return {};
+
+        mLru.splice(std::begin(mLru), mLru, entry.lruPos);
+        return entry.page;
+    }
+
+    if (mPendingReads >= MaxPendingReads)
+        return {};
+
+    const auto& info = mModel.GetPages()[pageIndex];
+    const size_t size = info.GetDataSize();
+    if (!MakeRoom(size))
+        return {};
+
+    Entry entry;
+    entry.size = size;
+    entry.pending = ThreadPool::Get().Submit([pagePath = mModel.GetPagePath(), info]() {
+        return PagedModel::ReadPage(pagePath, info);
+    });
+    mEntries.emplace(pageIndex, std::move(entry));
+
+    mMemoryUsage += size;
+    ++mPendingReads;
+    return {};
+}
+
+bool PageCache::MakeRoom(size_t size)
+{
+    while (mMemoryUsage + size > mMemoryLimit && !std::empty(mLru))
+    {
+        const uint32_t pageIndex = mLru.back();
+        mLru.pop_back();
+
+        auto it = mEntries.find(pageIndex);
+        mMemoryUsage -= it->second.size;
+        mEntries.erase(it);
+    }
+
+    return mMemoryUsage + size <= mMemoryLimit;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <future>
+#include <memory>
+#include <unordered_map>
+
+#include "GeometryPage.h"
+
+class PagedModel;
+
+// Host memory cache of a paged model's geometry. Pages are read on the thread pool and the
+// least recently requested ones are evicted so resident and in flight pages never take more
+// than the memory limit.
+class PageCache
+{
+public:
+    PageCache(const PagedModel& model, size_t memoryLimit);
+
+    PageCache(const PageCache&) = delete;
+    PageCache& operator=(const PageCache&) = delete;
+
+    // Returns the page if it's resident. Otherwise starts reading it when there is room and
+    // returns null, the caller asks again on a later frame.
+    std::shared_ptr<const GeometryPage> Request(uint32_t pageIndex);
+
+    size_t GetMemoryUsage() const { return mMemoryUsage; }
+    size_t GetMemoryLimit() const { return mMemoryLimit; }
+
+private:
+    bool MakeRoom(size_t size);
+
+private:
+    // Reads in flight at once, so a burst of requests doesn't fill the pool queue
+    static constexpr uint32_t MaxPendingReads = 16;
+
+    struct Entry
+    {
+        std::shared_ptr<const GeometryPage> page;
+        std::future<std::unique_ptr<GeometryPage>> pending;
+        std::list<uint32_t>::iterator lruPos;
+        size_t size = 0;
+        // Failed reads are not retried
+        bool failed = false;
+    };
+
+    const PagedModel& mModel;
+    size_t mMemoryLimit = 0;
+    size_t mMemoryUsage = 0;
+    uint32_t mPendingReads = 0;
+
+    std::unordered_map<uint32_t, Entry> mEntries;
+    // Resident pages, most recently requested first
+    std::list<uint32_t> mLru;
+};
@@ -0,0 +1,365 @@
+#include "PagedModel.h"
+
+#include "Model.h"
+#include "BinaryIO.h"
+#include "FileUtils.h"
+#include "VertexUtils.h"
+#include "Log.h"
+
+#include <fstream>
+
+namespace
+{
+    constexpr uint32_t PageFileMagic = 0x45474150; // "PAGE"
+    constexpr uint32_t PageFileVersion = 4;
+    constexpr size_t DataAlignment = 16;
+
+    struct PageFileHeader
+    {
+        uint32_t magic = PageFileMagic;
+        uint32_t version = PageFileVersion;
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        uint64_t sourceHash = 0;
+        uint64_t processingHash = 0;
+        // The page table follows the page data
+        uint64_t tableOffset = 0;
+        uint32_t pageCount = 0;
+        uint32_t padding = 0;
+    };
+
+    // Fills pages with consecutive triangles, which after the vertex cache and fetch
+    // optimizations share most of their vertices with their neighbours
+    template<typename F>
+    void SplitIntoPages(Span<const Vertex> vertices, const std::vector<uint32_t>& indices, F&& emitPage)
+    {
+        constexpr uint32_t Unassigned = ~0u;
+        std::vector<uint32_t> localIndices(std::size(vertices), Unassigned);
+        std::vector<uint32_t> pageVertices;
+        GeometryPage page;
+
+        const auto flush = [&]() {
+            if (std::empty(page.indices))
+                return;
+
+            emitPage(page);
+            for (const uint32_t v : pageVertices)
+                localIndices[v] = Unassigned;
+            pageVertices.clear();
+            page.vertices.clear();
+            page.indices.clear();
+        };
+
+        for (size_t i = 0; i + 2 < std::size(indices); i += 3)
+        {
+            uint32_t newVertices = 0;
+            for (size_t k = 0; k < 3; ++k)
+                newVertices += localIndices[indices[i + k]] == Unassigned ? 1 : 0;
+
+            if (std::size(page.vertices) + newVertices > GeometryPage::MaxVertices ||
+                std::size(page.indices) + 3 > GeometryPage::MaxIndices)
+            {
+                flush();
+            }
+
+            for (size_t k = 0; k < 3; ++k)
+            {
+                const uint32_t v = indices[i + k];
+                if (localIndices[v] == Unassigned)
+                {
+                    localIndices[v] = (uint32_t)std::size(page.vertices);
+                    page.vertices.push_back(vertices[v]);
+                    pageVertices.push_back(v);
+                }
+                page.indices.push_back((uint16_t)localIndices[v]);
+            }
+        }
+
+        flush();
+    }
+
+    void WritePadding(std::ofstream& file, uint64_t& offset)
+    {
+        constexpr char zeros[DataAlignment] = {};
+        const size_t padding = (DataAlignment - offset % DataAlignment) % DataAlignment;
+        file.write(zeros, (std::streamsize)padding);
+        offset += padding;
+    }
+}
+
+std::filesystem::path PagedModel::GetPagePath(const std::filesystem::path& sourcePath)
+{
+    auto pagePath = sourcePath;
+    pagePath += ".pages";
+    return pagePath;
+}
+
+std::unique_ptr<PagedModel> PagedModel::Load(const std::filesystem::path& sourcePath, const ModelLoadOptions& options)
+{
+    if (auto pagedModel = Open(sourcePath, options))
+        return pagedModel;
+
+    if (!Write(sourcePath, options))
+        return {};
+
+    return Open(sourcePath, options);
+}
+
+std::unique_ptr<PagedModel> PagedModel::Open(const std::filesystem::path& sourcePath, const ModelLoadOptions& options)
+{
+    const auto pagePath = GetPagePath(sourcePath);
+    std::ifstream file(pagePath, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+        return {};
+
+    try
+    {
+        PageFileHeader header;
+        file.read((char*)&header, sizeof(header));
+        if (!file)
+            throw std::runtime_error("Unexpected end of page file");
+
+        if (header.magic != PageFileMagic || header.version != PageFileVersion)
+        {
+            LOG_INFO("Page file {0} has an unsupported version, rebuilding", pagePath.string());
+            return {};
+        }
+
+        if (header.processingHash != options.GetProcessingHash())
+        {
+            LOG_INFO("Page file {0} was built with different load options, rebuilding", pagePath.string());
+            return {};
+        }
+
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        if (!FileUtils::GetFileStats(sourcePath, sourceSize, sourceWriteTime) ||
+            sourceSize != header.sourceSize || sourceWriteTime != header.sourceWriteTime)
+        {
+            LOG_INFO("Page file {0} is out of date, rebuilding", pagePath.string());
+            return {};
+        }
+
+        uint64_t sourceHash = 0;
+        if (!FileUtils::HashFile(sourcePath, sourceHash) || sourceHash != header.sourceHash)
+        {
+            LOG_INFO("Page file {0} does not match source contents, rebuilding", pagePath.string());
+            return {};
+        }
+
+        const uint64_t fileSize = (uint64_t)std::filesystem::file_size(pagePath);
+        if (header.tableOffset < sizeof(header) || header.tableOffset > fileSize)
+            throw std::runtime_error("Invalid page table offset");
+
+        std::vector<uint8_t> table(size_t(fileSize - header.tableOffset));
+        file.seekg((std::streamoff)header.tableOffset);
+        file.read((char*)std::data(table), (std::streamsize)std::size(table));
+        if (!file)
+            throw std::runtime_error("Unexpected end of page file");
+
+        BinaryReader reader(table);
+
+        auto pagedModel = std::make_unique<PagedModel>();
+        pagedModel->mName = reader.ReadString();
+        pagedModel->mBounds = reader.Read<Bounds>();
+
+        pagedModel->mTexturePaths.resize(reader.Read<uint32_t>());
+        for (auto& texturePath : pagedModel->mTexturePaths)
+            texturePath = reader.ReadString();
+
+        pagedModel->mMaterials.resize(reader.Read<uint32_t>());
+        for (auto& material : pagedModel->mMaterials)
+        {
+            material.name = reader.ReadString();
+            material.diffuseTexture = reader.Read<uint32_t>();
+            if (material.diffuseTexture != Material::NoTexture && material.diffuseTexture >= std::size(pagedModel->mTexturePaths))
+                throw std::runtime_error("Invalid texture index");
+        }
+
+        const auto meshCount = reader.Read<uint32_t>();
+        const auto nodeCount = reader.Read<uint32_t>();
+        const auto parents = reader.ReadArray<uint32_t>(nodeCount);
+        const auto localTransforms = reader.ReadArray<glm::mat4>(nodeCount, DataAlignment);
+        for (uint32_t i = 0; i < nodeCount; ++i)
+            pagedModel->mNodes.AddNode(parents[i], localTransforms[i]);
+
+        const auto instances = reader.ReadArray<MeshInstance>(reader.Read<uint32_t>());
+        for (const auto& instance : instances)
+        {
+            if (instance.meshIndex >= meshCount || instance.nodeIndex >= nodeCount)
+                throw std::runtime_error("Invalid mesh instance");
+        }
+        pagedModel->mInstances.assign(std::begin(instances), std::end(instances));
+
+        // Pages were written mesh by mesh
+        pagedModel->mMeshPages.resize(meshCount);
+        const auto pages = reader.ReadArray<GeometryPageInfo>(header.pageCount, DataAlignment);
+        for (uint32_t i = 0; i < header.pageCount; ++i)
+        {
+            const auto& page = pages[i];
+            if (page.vertexCount > GeometryPage::MaxVertices || page.indexCount > GeometryPage::MaxIndices ||
+                page.indexCount % 3 != 0 || page.dataOffset + page.GetDataSize() > header.tableOffset ||
+                page.meshIndex >= meshCount || (i > 0 && page.meshIndex < pages[i - 1].meshIndex))
+            {
+                throw std::runtime_error("Invalid page");
+            }
+
+            auto& range = pagedModel->mMeshPages[page.meshIndex];
+            if (range.pageCount == 0)
+                range.firstPage = i;
+            ++range.pageCount;
+        }
+
+        pagedModel->mPages.assign(std::begin(pages), std::end(pages));
+        pagedModel->mPagePath = pagePath;
+
+        LOG_INFO("Opened page file {0} with {1} pages", pagePath.string(), std::size(pagedModel->mPages));
+        return pagedModel;
+    }
+    catch (const std::exception& e)
+    {
+        LOG_WARN("Failed to read page file {0}: {1}", pagePath.string(), e.what());
+        return {};
+    }
+}
+
+bool PagedModel::Write(const std::filesystem::path& sourcePath, const ModelLoadOptions& options)
+{
+    const auto pagePath = GetPagePath(sourcePath);
+
+    PageFileHeader header;
+    header.processingHash = options.GetProcessingHash();
+    if (!FileUtils::GetFileStats(sourcePath, header.sourceSize, header.sourceWriteTime) ||
+        !FileUtils::HashFile(sourcePath, header.sourceHash))
+    {
+        LOG_WARN("Failed to fingerprint {0}, not writing page file", sourcePath.string());
+        return false;
+    }
+
+    // Write to a temporary file first so a partially written page file is never picked up.
+    // The source is imported one mesh at a time and its pages go straight to the file, so only one
+    // processed mesh and one page are held at once.
+    auto tempPath = pagePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_WARN("Failed to open {0} for writing", tempPath.string());
+            return false;
+        }
+
+        file.write((const char*)&header, sizeof(header));
+        uint64_t offset = sizeof(header);
+
+        std::vector<GeometryPageInfo> pages;
+        uint32_t meshCount = 0;
+        const auto model = Model::ImportEach(sourcePath, options, [&](uint32_t meshIndex, const Mesh& mesh) {
+            meshCount = meshIndex + 1;
+            SplitIntoPages(mesh.GetVertices(), mesh.CopyIndices(), [&](const GeometryPage& page) {
+                WritePadding(file, offset);
+
+                GeometryPageInfo info;
+                info.dataOffset = offset;
+                info.vertexCount = (uint32_t)std::size(page.vertices);
+                info.indexCount = (uint32_t)std::size(page.indices);
+                info.meshIndex = meshIndex;
+                info.materialIndex = mesh.GetMaterialIndex();
+                info.bounds = VertexUtils::ComputeBounds(page.vertices);
+                pages.push_back(info);
+
+                file.write((const char*)std::data(page.vertices), std::size(page.vertices) * sizeof(Vertex));
+                file.write((const char*)std::data(page.indices), std::size(page.indices) * sizeof(uint16_t));
+                offset += page.GetMemorySize();
+            });
+        });
+        if (!model)
+            return false;
+
+        WritePadding(file, offset);
+        header.tableOffset = offset;
+        header.pageCount = (uint32_t)std::size(pages);
+
+        BinaryWriter writer;
+        writer.WriteString(model->GetName());
+        writer.Write(model->GetBounds());
+
+        writer.Write((uint32_t)std::size(model->GetTexturePaths()));
+        for (const auto& texturePath : model->GetTexturePaths())
+            writer.WriteString(texturePath);
+
+        writer.Write((uint32_t)std::size(model->GetMaterials()));
+        for (const auto& material : model->GetMaterials())
+        {
+            writer.WriteString(material.name);
+            writer.Write(material.diffuseTexture);
+        }
+
+        writer.Write(meshCount);
+        writer.Write(model->GetNodes().GetNodeCount());
+        writer.WriteArray(Span<const uint32_t>(model->GetNodes().GetParents()));
+        writer.WriteArray(Span<const glm::mat4>(model->GetNodes().GetLocalTransforms()), DataAlignment);
+
+        writer.Write((uint32_t)std::size(model->GetInstances()));
+        writer.WriteArray(Span<const MeshInstance>(model->GetInstances()));
+
+        writer.WriteArray(Span<const GeometryPageInfo>(pages), DataAlignment);
+
+        const auto& buffer = writer.GetBuffer();
+        file.write((const char*)std::data(buffer), (std::streamsize)std::size(buffer));
+
+        file.seekp(0);
+        file.write((const char*)&header, sizeof(header));
+        if (!file)
+        {
+            LOG_WARN("Failed to write page file {0}", tempPath.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, pagePath, ec);
+    if (ec)
+    {
+        LOG_WARN("Failed to replace page file {0}: {1}", pagePath.string(), ec.message());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    LOG_INFO("Wrote page file {0} with {1} pages", pagePath.string(), header.pageCount);
+    return true;
+}
+
+std::unique_ptr<GeometryPage> PagedModel::ReadPage(const std::filesystem::path& pagePath, const GeometryPageInfo& info)
+{
+    std::ifstream file(pagePath, std::ios::in | std::ios::binary);
+    if (!file.is_open())
+    {
+        LOG_ERROR("Failed to open page file {0}", pagePath.string());
+        return {};
+    }
+
+    auto page = std::make_unique<GeometryPage>();
+    page->vertices.resize(info.vertexCount);
+    page->indices.resize(info.indexCount);
+
+    file.seekg((std::streamoff)info.dataOffset);
+    file.read((char*)std::data(page->vertices), std::size(page->vertices) * sizeof(Vertex));
+    file.read((char*)std::data(page->indices), std::size(page->indices) * sizeof(uint16_t));
+    if (!file)
+    {
+        LOG_ERROR("Failed to read page at {0} from {1}", info.dataOffset, pagePath.string());
+        return {};
+    }
+
+    for (const uint16_t index : page->indices)
+    {
+        if (index >= info.vertexCount)
+        {
+            LOG_ERROR("Invalid index in page at {0} from {1}", info.dataOffset, pagePath.string());
+            return {};
+        }
+    }
+
+    return page;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "GeometryPage.h"
+#include "Bounds.h"
+#include "Material.h"
+#include "NodeHierarchy.h"
+
+struct ModelLoadOptions;
+
+// Model stored as geometry pages in a file next to the source asset. Only the page table is kept
+// in memory, the pages themselves are read on demand, so models larger than RAM can be opened.
+class PagedModel
+{
+public:
+    PagedModel() = default;
+
+    const std::string& GetName() const { return mName; }
+    const std::vector<Material>& GetMaterials() const { return mMaterials; }
+    const std::vector<std::string>& GetTexturePaths() const { return mTexturePaths; }
+    const Bounds& GetBounds() const { return mBounds; }
+    const std::vector<GeometryPageInfo>& GetPages() const { return mPages; }
+    const NodeHierarchy& GetNodes() const { return mNodes; }
+    const std::vector<MeshInstance>& GetInstances() const { return mInstances; }
+
+    // Pages of a mesh are stored next to each other, every instance of the mesh draws the same pages
+    struct PageRange
+    {
+        uint32_t firstPage = 0;
+        uint32_t pageCount = 0;
+    };
+    const std::vector<PageRange>& GetMeshPages() const { return mMeshPages; }
+    const std::filesystem::path& GetPagePath() const { return mPagePath; }
+
+    static std::filesystem::path GetPagePath(const std::filesystem::path& sourcePath);
+
+    // Opens the page file for the source, building it first if it's missing or out of date.
+    // Building reads the source one mesh at a time, opening an existing page file doesn't read it at all.
+    static std::unique_ptr<PagedModel> Load(const std::filesystem::path& sourcePath, const ModelLoadOptions& options);
+
+    static bool Write(const std::filesystem::path& sourcePath, const ModelLoadOptions& options);
+
+    // Safe to call from any thread, returns null on a read error
+    static std::unique_ptr<GeometryPage> ReadPage(const std::filesystem::path& pagePath, const GeometryPageInfo& info);
+
+private:
+    static std::unique_ptr<PagedModel> Open(const std::filesystem::path& sourcePath, const ModelLoadOptions& options);
+
+private:
+    std::string mName;
+    std::vector<Material> mMaterials;
+    std::vector<std::string> mTexturePaths;
+    Bounds mBounds;
+
+    std::filesystem::path mPagePath;
+    std::vector<GeometryPageInfo> mPages;
+    std::vector<PageRange> mMeshPages;
+    NodeHierarchy mNodes;
+    std::vector<MeshInstance> mInstances;
+};
@@ -60,3 +60,12 @@ std::optional<uint32_t> Properties::GetUInt32(const std::string& key) const
 
 	return (uint32_t)std::stoi(iter->second);
 }
+
+std::optional<float> Properties::GetFloat(const std::string& key) const
+{
+	const auto iter = mProperties.find(key);
+	if (iter == std::end(mProperties))
+		return {};
+
+	return std::stof(iter->second);
+}
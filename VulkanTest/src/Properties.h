@@ -15,6 +15,7 @@ public:
 
 	std::optional<std::string> GetString(const std::string& key) const;
 	std::optional<uint32_t> GetUInt32(const std::string& key) const;
+	std::optional<float> GetFloat(const std::string& key) const;
 
 private:
 	std::map<std::string, std::string> mProperties;
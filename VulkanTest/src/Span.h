@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+// Non-owning view over contiguous memory, used to hand out mesh data that may
+// live in a std::vector or directly inside a memory mapped file.
+template<typename T>
+class Span
+{
+public:
+    Span() = default;
+    Span(T* data, size_t size) : mData(data), mSize(size) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<U(*)[], T(*)[]>>>
+    Span(std::vector<U>& vec) : mData(std::data(vec)), mSize(std::size(vec)) {}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible_v<const U(*)[], T(*)[]>>>
+    Span(const std::vector<U>& vec) : mData(std::data(vec)), mSize(std::size(vec)) {}
+
+    T* data() const { return mData; }
+    size_t size() const { return mSize; }
+    size_t size_bytes() const { return mSize * sizeof(T); }
+    bool empty() const { return mSize == 0; }
+
+    T* begin() const { return mData; }
+    T* end() const { return mData + mSize; }
+
+    T& operator[](size_t i) const { return mData[i]; }
+
+    Span subspan(size_t offset, size_t count) const { return Span(mData + offset, count); }
+
+private:
+    T* mData = nullptr;
+    size_t mSize = 0;
+};
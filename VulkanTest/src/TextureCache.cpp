@@ -0,0 +1,171 @@
+#include "TextureCache.h"
+
+#include "Image.h"
+#include "BlockCompression.h"
+#include "MappedFile.h"
+#include "BinaryIO.h"
+#include "FileUtils.h"
+#include "Log.h"
+
+#include <fstream>
+#include <algorithm>
+
+namespace
+{
+    constexpr uint32_t CacheMagic = 0x58544d54; // "TMTX"
+    constexpr uint32_t CacheVersion = 4;
+    constexpr size_t DataAlignment = 16;
+
+    // Decoding the source is what the cache avoids, so it is only fingerprinted by size and write time
+    struct CacheHeader
+    {
+        uint32_t magic = CacheMagic;
+        uint32_t version = CacheVersion;
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t mipCount = 0;
+        // The requested compression, the format can differ from it when BC1 is promoted to BC3 for alpha
+        uint32_t compression = 0;
+        uint32_t format = 0;
+        uint32_t padding = 0;
+        uint64_t dataSize = 0;
+    };
+}
+
+std::filesystem::path TextureCache::GetCachePath(const std::filesystem::path& sourcePath)
+{
+    auto cachePath = sourcePath;
+    cachePath += ".texcache";
+    return cachePath;
+}
+
+std::unique_ptr<Image> TextureCache::Load(const std::filesystem::path& sourcePath, TextureCompression compression)
+{
+    const auto cachePath = GetCachePath(sourcePath);
+    auto cacheFile = MappedFile::Open(cachePath);
+    if (!cacheFile)
+        return {};
+
+    try
+    {
+        BinaryReader reader(cacheFile->GetBytes());
+
+        const auto header = reader.Read<CacheHeader>();
+        if (header.magic != CacheMagic || header.version != CacheVersion)
+        {
+            LOG_INFO("Texture cache {0} has an unsupported version, rebuilding", cachePath.string());
+            return {};
+        }
+
+        if (header.compression != (uint32_t)compression)
+        {
+            LOG_INFO("Texture cache {0} was cooked with a different compression, rebuilding", cachePath.string());
+            return {};
+        }
+
+        uint64_t sourceSize = 0;
+        int64_t sourceWriteTime = 0;
+        if (!FileUtils::GetFileStats(sourcePath, sourceSize, sourceWriteTime) ||
+            sourceSize != header.sourceSize || sourceWriteTime != header.sourceWriteTime)
+        {
+            LOG_INFO("Texture cache {0} is out of date, rebuilding", cachePath.string());
+            return {};
+        }
+
+        if (header.width == 0 || header.height == 0 || header.mipCount != Image::GetMipCount(header.width, header.height))
+            throw std::runtime_error("Invalid image size");
+
+        const auto format = (VkFormat)header.format;
+        if (format != VK_FORMAT_R8G8B8A8_SRGB && !BlockCompression::IsBlockCompressed(format))
+            throw std::runtime_error("Invalid image format");
+
+        auto image = std::make_unique<Image>();
+        image->mWidth = header.width;
+        image->mHeight = header.height;
+        image->mFormat = format;
+
+        const auto mips = reader.ReadArray<ImageMip>(header.mipCount);
+        image->mPixelView = reader.ReadArray<uint8_t>(header.dataSize, DataAlignment);
+
+        // Every level must be half the size of the one before and lie inside the pixel data
+        uint32_t width = header.width;
+        uint32_t height = header.height;
+        for (const auto& mip : mips)
+        {
+            if (mip.width != width || mip.height != height || mip.size != BlockCompression::GetImageSize(format, width, height) ||
+                mip.offset > header.dataSize || mip.size > header.dataSize - mip.offset || mip.offset % BlockCompression::GetBlockSize(format) != 0)
+            {
+                throw std::runtime_error("Invalid mip level");
+            }
+
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+        image->mMips.assign(std::begin(mips), std::end(mips));
+
+        image->mMappedFile = std::move(cacheFile);
+        return image;
+    }
+    catch (const std::exception& e)
+    {
+        LOG_WARN("Failed to read texture cache {0}: {1}", cachePath.string(), e.what());
+        return {};
+    }
+}
+
+bool TextureCache::Write(const std::filesystem::path& sourcePath, const Image& image, TextureCompression compression)
+{
+    const auto cachePath = GetCachePath(sourcePath);
+
+    CacheHeader header;
+    header.width = image.GetWidth();
+    header.height = image.GetHeight();
+    header.mipCount = (uint32_t)std::size(image.GetMips());
+    header.compression = (uint32_t)compression;
+    header.format = (uint32_t)image.GetFormat();
+    header.dataSize = std::size(image.GetPixels());
+    if (!FileUtils::GetFileStats(sourcePath, header.sourceSize, header.sourceWriteTime))
+    {
+        LOG_WARN("Failed to fingerprint {0}, not writing texture cache", sourcePath.string());
+        return false;
+    }
+
+    BinaryWriter writer;
+    writer.Write(header);
+    writer.WriteArray(Span<const ImageMip>(image.GetMips()));
+    writer.WriteArray(image.GetPixels(), DataAlignment);
+
+    // Write to a temporary file first so a partially written cache is never picked up
+    auto tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_WARN("Failed to open {0} for writing", tempPath.string());
+            return false;
+        }
+
+        const auto& buffer = writer.GetBuffer();
+        file.write((const char*)std::data(buffer), (std::streamsize)std::size(buffer));
+        if (!file)
+        {
+            LOG_WARN("Failed to write texture cache {0}", tempPath.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec)
+    {
+        LOG_WARN("Failed to replace texture cache {0}: {1}", cachePath.string(), ec.message());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    LOG_INFO("Wrote texture cache {0}", cachePath.string());
+    return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <filesystem>
+#include <memory>
+
+class Image;
+enum class TextureCompression;
+
+// Versioned binary cache of a decoded or block compressed texture and its full mip chain stored next to the source image.
+// The levels are laid out the way they are uploaded, a valid cache is memory mapped and copied to
+// the staging buffer as is.
+class TextureCache
+{
+public:
+    static std::filesystem::path GetCachePath(const std::filesystem::path& sourcePath);
+
+    // A cache cooked with a different compression is rebuilt
+    static std::unique_ptr<Image> Load(const std::filesystem::path& sourcePath, TextureCompression compression);
+    static bool Write(const std::filesystem::path& sourcePath, const Image& image, TextureCompression compression);
+};
@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <algorithm>
+#include <exception>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    threadCount = std::max(threadCount, 1u);
+    mWorkers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+        mWorkers.emplace_back([this]() { WorkerLoop(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mCondition.notify_all();
+
+    for (auto& worker : mWorkers)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& func)
+{
+    if (count == 0)
+        return;
+
+    // Helpers can start after this call has returned, so the state they use is shared
+    struct State
+    {
+        std::function<void(size_t)> func;
+        size_t count = 0;
+        std::atomic<size_t> next{ 0 };
+        std::atomic<size_t> done{ 0 };
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr exception;
+    };
+
+    auto state = std::make_shared<State>();
+    state->func = func;
+    state->count = count;
+
+    const auto work = [](State& s) {
+        for (size_t i = s.next++; i < s.count; i = s.next++)
+        {
+            try
+            {
+                s.func(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                if (!s.exception)
+                    s.exception = std::current_exception();
+            }
+
+            if (++s.done == s.count)
+            {
+                std::lock_guard<std::mutex> lock(s.mutex);
+                s.finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helperCount = std::min<size_t>(GetThreadCount(), count - 1);
+    for (size_t i = 0; i < helperCount; ++i)
+        Enqueue([state, work]() { work(*state); });
+
+    work(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&]() { return state->done == state->count; });
+    if (state->exception)
+        std::rethrow_exception(state->exception);
+}
+
+namespace
+{
+    uint32_t sSharedThreadCount = 0;
+    thread_local ThreadPool* sWorkerPool = nullptr;
+}
+
+ThreadPool& ThreadPool::Get()
+{
+    if (sWorkerPool)
+        return *sWorkerPool;
+
+    static ThreadPool pool(sSharedThreadCount != 0 ? sSharedThreadCount : std::thread::hardware_concurrency());
+    return pool;
+}
+
+void ThreadPool::SetSharedThreadCount(uint32_t threadCount)
+{
+    sSharedThreadCount = threadCount;
+}
+
+void ThreadPool::Enqueue(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTasks.push(std::move(task));
+    }
+    mCondition.notify_one();
+}
+
+void ThreadPool::WorkerLoop()
+{
+    sWorkerPool = this;
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mCondition.wait(lock, [this]() { return mStopping || !std::empty(mTasks); });
+            if (mStopping && std::empty(mTasks))
+                return;
+
+            task = std::move(mTasks.front());
+            mTasks.pop();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    uint32_t GetThreadCount() const { return (uint32_t)std::size(mWorkers); }
+
+    template<typename F>
+    std::future<std::invoke_result_t<F>> Submit(F&& func)
+    {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(func));
+        auto future = task->get_future();
+        Enqueue([task]() { (*task)(); });
+        return future;
+    }
+
+    // Calls func for every index in [0, count) and returns once all calls are done. The calling
+    // thread helps out, so this is safe to use from inside a pool task. The first exception
+    // thrown by func is rethrown here.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& func);
+
+    // Pool of the calling worker thread, so work a task splits up stays in its pool. Otherwise the shared
+    // pool, sized to the number of hardware threads unless SetSharedThreadCount was called first
+    static ThreadPool& Get();
+    // Only has an effect before the first Get, 0 keeps the hardware thread count
+    static void SetSharedThreadCount(uint32_t threadCount);
+
+private:
+    void Enqueue(std::function<void()> task);
+    void WorkerLoop();
+
+private:
+    std::vector<std::thread> mWorkers;
+    std::queue<std::function<void()>> mTasks;
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    bool mStopping = false;
+};
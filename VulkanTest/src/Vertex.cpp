@@ -1,5 +1,19 @@
 #include "Vertex.h"
 
+#include "HashUtils.h"
+
+uint64_t Vertex::GetHash() const
+{
+    // Adding zero turns -0.0 into 0.0 so the bytes match whenever operator== does
+    Vertex normalized;
+    normalized.pos = pos + 0.0f;
+    normalized.normal = normal + 0.0f;
+    normalized.color = color + 0.0f;
+    normalized.texCoord = texCoord + 0.0f;
+
+    return HashUtils::Hash64(&normalized, sizeof(normalized));
+}
+
 std::array<VkVertexInputBindingDescription, 1> Vertex::GetBindingDescriptions()
 {
     std::array<VkVertexInputBindingDescription, 1> bindingDescs{};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
 
 #include <vulkan/vulkan.h>
 
@@ -20,6 +21,9 @@ struct Vertex
             && color == other.color && texCoord == other.texCoord;
     }
 
+    // Hash of every attribute, equal vertices always hash the same
+    uint64_t GetHash() const;
+
     static std::array<VkVertexInputBindingDescription, 1> GetBindingDescriptions();
 
     static std::array<VkVertexInputAttributeDescription, 4> GetAttributeDescriptions();
@@ -32,9 +36,7 @@ namespace std
     {
         size_t operator()(const Vertex& vert) const
         {
-            return ((hash<glm::vec3>()(vert.pos) ^
-                (hash<glm::vec3>()(vert.color) << 1)) >> 1) ^
-                (hash<glm::vec2>()(vert.texCoord) << 1);
+            return (size_t)vert.GetHash();
         }
     };
 }
@@ -0,0 +1,86 @@
+#include "VertexLayout.h"
+
+#include <cstring>
+
+size_t VertexLayout::GetVertexSize() const
+{
+    return format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+}
+
+size_t VertexLayout::GetPositionSize() const
+{
+    return format == VertexFormat::Packed ? sizeof(PackedVertex::pos) : sizeof(Vertex::pos);
+}
+
+std::vector<VkVertexInputBindingDescription> VertexLayout::GetBindingDescriptions() const
+{
+    const auto interleaved = format == VertexFormat::Packed ?
+        PackedVertex::GetBindingDescriptions() : Vertex::GetBindingDescriptions();
+
+    std::vector<VkVertexInputBindingDescription> bindingDescs(std::begin(interleaved), std::end(interleaved));
+    if (streams == VertexStreams::SplitPosition)
+    {
+        bindingDescs[0].stride = (uint32_t)GetPositionSize();
+
+        VkVertexInputBindingDescription attrBinding{};
+        attrBinding.binding = 1;
+        attrBinding.stride = uint32_t(GetVertexSize() - GetPositionSize());
+        attrBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        bindingDescs.push_back(attrBinding);
+    }
+
+    return bindingDescs;
+}
+
+std::vector<VkVertexInputAttributeDescription> VertexLayout::GetAttributeDescriptions() const
+{
+    const auto interleaved = format == VertexFormat::Packed ?
+        PackedVertex::GetAttributeDescriptions() : Vertex::GetAttributeDescriptions();
+
+    std::vector<VkVertexInputAttributeDescription> attrDescs(std::begin(interleaved), std::end(interleaved));
+    if (streams == VertexStreams::SplitPosition)
+    {
+        for (auto& attrDesc : attrDescs)
+        {
+            if (attrDesc.location == 0)
+                continue;
+
+            attrDesc.binding = 1;
+            attrDesc.offset -= (uint32_t)GetPositionSize();
+        }
+    }
+
+    return attrDescs;
+}
+
+void VertexLayout::WriteVertices(Span<const Vertex> vertices, const PositionQuantization& quantization,
+    uint8_t* dst, uint8_t* attrDst) const
+{
+    const bool packed = format == VertexFormat::Packed;
+    const bool split = streams == VertexStreams::SplitPosition;
+    if (!packed && !split)
+    {
+        memcpy(dst, std::data(vertices), vertices.size_bytes());
+        return;
+    }
+
+    const size_t vertexSize = GetVertexSize();
+    const size_t positionSize = GetPositionSize();
+    for (const auto& vertex : vertices)
+    {
+        const PackedVertex packedVertex = packed ? PackedVertex::Pack(vertex, quantization) : PackedVertex{};
+        const uint8_t* src = packed ? (const uint8_t*)&packedVertex : (const uint8_t*)&vertex;
+        if (split)
+        {
+            memcpy(dst, src, positionSize);
+            memcpy(attrDst, src + positionSize, vertexSize - positionSize);
+            dst += positionSize;
+            attrDst += vertexSize - positionSize;
+        }
+        else
+        {
+            memcpy(dst, src, vertexSize);
+            dst += vertexSize;
+        }
+    }
+}
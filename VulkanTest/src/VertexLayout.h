@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "PackedVertex.h"
+#include "Span.h"
+
+enum class VertexStreams
+{
+    // One binding with every attribute
+    Interleaved,
+    // Positions in binding 0 and the remaining attributes in binding 1, so
+    // depth only passes can bind just the position stream
+    SplitPosition
+};
+
+struct VertexLayout
+{
+    VertexFormat format = VertexFormat::Float;
+    VertexStreams streams = VertexStreams::Interleaved;
+
+    size_t GetVertexSize() const;
+    // Size of the position attribute, which is always first in the vertex
+    size_t GetPositionSize() const;
+
+    std::vector<VkVertexInputBindingDescription> GetBindingDescriptions() const;
+    std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() const;
+
+    // Converts the vertices to this layout. Interleaved layouts only write to dst, split layouts
+    // write the positions to dst and the remaining attributes to attrDst.
+    void WriteVertices(Span<const Vertex> vertices, const PositionQuantization& quantization,
+        uint8_t* dst, uint8_t* attrDst) const;
+};
@@ -0,0 +1,200 @@
+#include "VertexUtils.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define VERTEX_UTILS_SSE 1
+#   include <emmintrin.h>
+#else
+#   define VERTEX_UTILS_SSE 0
+#endif
+
+// The AVX2 kernel is built on every x64 target and picked at runtime, the project doesn't require AVX2
+#if defined(_M_X64) || defined(__x86_64__)
+#   define VERTEX_UTILS_AVX2 1
+#   include <immintrin.h>
+#   if defined(_MSC_VER) && !defined(__clang__)
+#       include <intrin.h>
+#       define VERTEX_UTILS_AVX2_TARGET
+#   else
+#       define VERTEX_UTILS_AVX2_TARGET __attribute__((target("avx2")))
+#   endif
+#else
+#   define VERTEX_UTILS_AVX2 0
+#endif
+
+namespace VertexUtils
+{
+    namespace
+    {
+        static_assert(sizeof(Vertex) == 11 * sizeof(float), "ConvertVertices expects a tightly packed Vertex");
+
+        const Vertex DefaultVertex;
+
+        void ConvertVerticesScalar(Vertex* dst, size_t begin, size_t end, const float* positions, const float* normals,
+            const float* colors, const float* texCoords)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                Vertex& vert = dst[i];
+                vert.pos = positions ? glm::vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]) : DefaultVertex.pos;
+                vert.normal = normals ? glm::vec3(normals[i * 3], normals[i * 3 + 1], normals[i * 3 + 2]) : DefaultVertex.normal;
+                vert.color = colors ? glm::vec3(colors[i * 4], colors[i * 4 + 1], colors[i * 4 + 2]) : DefaultVertex.color;
+                vert.texCoord = texCoords ? glm::vec2(texCoords[i * 3], texCoords[i * 3 + 1]) : DefaultVertex.texCoord;
+            }
+        }
+
+#if VERTEX_UTILS_SSE
+        // Each attribute is moved with one 4 float load and store. The stores run front to back so
+        // the extra lane written past an attribute is overwritten by the next attribute, and the
+        // texture coordinates are stored with a 2 float store so nothing is written past the vertex.
+        // The 3 float sources are over-read by one float, so the last vertex goes through the scalar path.
+        size_t ConvertVerticesSSE(Vertex* dst, size_t count, const float* positions, const float* normals,
+            const float* colors, const float* texCoords)
+        {
+            const size_t simdCount = count > 0 ? count - 1 : 0;
+
+            const __m128 defaultPos = _mm_setr_ps(DefaultVertex.pos.x, DefaultVertex.pos.y, DefaultVertex.pos.z, 0.0f);
+            const __m128 defaultNormal = _mm_setr_ps(DefaultVertex.normal.x, DefaultVertex.normal.y, DefaultVertex.normal.z, 0.0f);
+            const __m128 defaultColor = _mm_setr_ps(DefaultVertex.color.x, DefaultVertex.color.y, DefaultVertex.color.z, 0.0f);
+            const __m128 defaultTexCoord = _mm_setr_ps(DefaultVertex.texCoord.x, DefaultVertex.texCoord.y, 0.0f, 0.0f);
+
+            for (size_t i = 0; i < simdCount; ++i)
+            {
+                float* out = (float*)&dst[i];
+
+                const __m128 pos = positions ? _mm_loadu_ps(positions + i * 3) : defaultPos;
+                const __m128 normal = normals ? _mm_loadu_ps(normals + i * 3) : defaultNormal;
+                const __m128 color = colors ? _mm_loadu_ps(colors + i * 4) : defaultColor;
+                const __m128 texCoord = texCoords ? _mm_loadu_ps(texCoords + i * 3) : defaultTexCoord;
+
+                _mm_storeu_ps(out + 0, pos);
+                _mm_storeu_ps(out + 3, normal);
+                _mm_storeu_ps(out + 6, color);
+                _mm_storel_pi((__m64*)(out + 9), texCoord);
+            }
+
+            return simdCount;
+        }
+#endif
+
+#if VERTEX_UTILS_AVX2
+        bool HasAvx2()
+        {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return false;
+
+            // The OS has to save the YMM registers as well
+            __cpuid(info, 1);
+            const bool osAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+            __cpuidex(info, 7, 0);
+            return osAvx && (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+
+        // Two vertices per step, one 8 float load per attribute and 22 floats written with two full stores
+        // and a 6 float tail store. The positions are already in the lanes they are stored from, the other
+        // attributes are moved into place with lane permutes and merged with blends.
+        // The 3 float sources are over-read by two floats, so at least the last two vertices go through the scalar path.
+        VERTEX_UTILS_AVX2_TARGET size_t ConvertVerticesAvx2(Vertex* dst, size_t count, const float* positions, const float* normals,
+            const float* colors, const float* texCoords)
+        {
+            const Vertex& d = DefaultVertex;
+            const __m256 defaultPos = _mm256_setr_ps(d.pos.x, d.pos.y, d.pos.z, d.pos.x, d.pos.y, d.pos.z, 0.0f, 0.0f);
+            const __m256 defaultNormal = _mm256_setr_ps(d.normal.x, d.normal.y, d.normal.z, d.normal.x, d.normal.y, d.normal.z, 0.0f, 0.0f);
+            const __m256 defaultColor = _mm256_setr_ps(d.color.x, d.color.y, d.color.z, 0.0f, d.color.x, d.color.y, d.color.z, 0.0f);
+            const __m256 defaultTexCoord = _mm256_setr_ps(d.texCoord.x, d.texCoord.y, 0.0f, d.texCoord.x, d.texCoord.y, 0.0f, 0.0f, 0.0f);
+
+            // Source lane of every output lane that isn't a position
+            // out0: p0 p0 p0 n0 n0 n0 c0 c0   out1: c0 t0 t0 p1 p1 p1 n1 n1   out2: n1 c1 c1 c1 t1 t1
+            const __m256i normalIndex0 = _mm256_setr_epi32(0, 0, 0, 0, 1, 2, 0, 0);
+            const __m256i colorIndex0 = _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 0, 1);
+            const __m256i colorTexCoordIndex1 = _mm256_setr_epi32(2, 0, 1, 0, 0, 0, 0, 0);
+            const __m256i normalIndex1 = _mm256_setr_epi32(0, 0, 0, 0, 0, 0, 3, 4);
+            const __m256i normalIndex2 = _mm256_setr_epi32(5, 0, 0, 0, 0, 0, 0, 0);
+            const __m256i colorIndex2 = _mm256_setr_epi32(0, 4, 5, 6, 0, 0, 0, 0);
+            const __m256i texCoordIndex2 = _mm256_setr_epi32(0, 0, 0, 0, 3, 4, 0, 0);
+
+            size_t i = 0;
+            for (; i + 3 <= count; i += 2)
+            {
+                float* out = (float*)&dst[i];
+
+                const __m256 pos = positions ? _mm256_loadu_ps(positions + i * 3) : defaultPos;
+                const __m256 normal = normals ? _mm256_loadu_ps(normals + i * 3) : defaultNormal;
+                const __m256 color = colors ? _mm256_loadu_ps(colors + i * 4) : defaultColor;
+                const __m256 texCoord = texCoords ? _mm256_loadu_ps(texCoords + i * 3) : defaultTexCoord;
+
+                const __m256 out0 = _mm256_blend_ps(_mm256_blend_ps(pos, _mm256_permutevar8x32_ps(normal, normalIndex0), 0x38),
+                    _mm256_permutevar8x32_ps(color, colorIndex0), 0xc0);
+                const __m256 colorTexCoord = _mm256_blend_ps(color, texCoord, 0x03);
+                const __m256 out1 = _mm256_blend_ps(_mm256_blend_ps(_mm256_permutevar8x32_ps(colorTexCoord, colorTexCoordIndex1), pos, 0x38),
+                    _mm256_permutevar8x32_ps(normal, normalIndex1), 0xc0);
+                const __m256 out2 = _mm256_blend_ps(_mm256_blend_ps(_mm256_permutevar8x32_ps(normal, normalIndex2),
+                    _mm256_permutevar8x32_ps(color, colorIndex2), 0x0e), _mm256_permutevar8x32_ps(texCoord, texCoordIndex2), 0x30);
+
+                _mm256_storeu_ps(out + 0, out0);
+                _mm256_storeu_ps(out + 8, out1);
+                _mm_storeu_ps(out + 16, _mm256_castps256_ps128(out2));
+                _mm_storel_pi((__m64*)(out + 20), _mm256_extractf128_ps(out2, 1));
+            }
+
+            return i;
+        }
+#endif
+    }
+
+    void ConvertVertices(Vertex* dst, size_t count, const float* positions, const float* normals,
+        const float* colors, const float* texCoords)
+    {
+        size_t converted = 0;
+#if VERTEX_UTILS_AVX2
+        static const bool hasAvx2 = HasAvx2();
+        if (hasAvx2)
+            converted = ConvertVerticesAvx2(dst, count, positions, normals, colors, texCoords);
+#endif
+#if VERTEX_UTILS_SSE
+        if (converted == 0)
+            converted = ConvertVerticesSSE(dst, count, positions, normals, colors, texCoords);
+#endif
+        ConvertVerticesScalar(dst, converted, count, positions, normals, colors, texCoords);
+    }
+
+    Bounds ComputeBounds(Span<const Vertex> vertices)
+    {
+        if (std::empty(vertices))
+            return {};
+
+#if VERTEX_UTILS_SSE
+        // Loads pos and the first normal component, the fourth lane is ignored
+        __m128 min = _mm_loadu_ps(&vertices[0].pos.x);
+        __m128 max = min;
+        for (const auto& vertex : vertices)
+        {
+            const __m128 pos = _mm_loadu_ps(&vertex.pos.x);
+            min = _mm_min_ps(min, pos);
+            max = _mm_max_ps(max, pos);
+        }
+
+        alignas(16) float minValues[4];
+        alignas(16) float maxValues[4];
+        _mm_store_ps(minValues, min);
+        _mm_store_ps(maxValues, max);
+        return Bounds::FromMinMax(glm::vec3(minValues[0], minValues[1], minValues[2]),
+            glm::vec3(maxValues[0], maxValues[1], maxValues[2]));
+#else
+        glm::vec3 min = vertices[0].pos;
+        glm::vec3 max = vertices[0].pos;
+        for (const auto& vertex : vertices)
+        {
+            min = glm::min(min, vertex.pos);
+            max = glm::max(max, vertex.pos);
+        }
+
+        return Bounds::FromMinMax(min, max);
+#endif
+    }
+}
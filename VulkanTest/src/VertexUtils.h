@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Vertex.h"
+#include "Bounds.h"
+#include "Span.h"
+
+namespace VertexUtils
+{
+    // Fills count vertices from separate attribute arrays. Positions, normals and texture
+    // coordinates are read as 3 floats per vertex and colors as 4 floats (RGBA, alpha dropped).
+    // A null attribute array is replaced by the Vertex default for that attribute.
+    void ConvertVertices(Vertex* dst, size_t count, const float* positions, const float* normals,
+        const float* colors, const float* texCoords);
+
+    // Bounds of the vertex positions in one pass, the sphere is the one around the box
+    Bounds ComputeBounds(Span<const Vertex> vertices);
+}
@@ -107,6 +107,19 @@ namespace vk::utils
         return VK_SAMPLE_COUNT_1_BIT;
     }
 
+    uint32_t GetIndexSize(VkIndexType indexType)
+    {
+        switch (indexType)
+        {
+        case VK_INDEX_TYPE_UINT16:
+            return sizeof(uint16_t);
+        case VK_INDEX_TYPE_UINT32:
+            return sizeof(uint32_t);
+        default:
+            throw std::invalid_argument("Unsupported index type");
+        }
+    }
+
     VkShaderModule CreateShaderModule(VkDevice device, const std::filesystem::path& filepath)
     {
         const auto code = FileUtils::ReadFile(filepath);
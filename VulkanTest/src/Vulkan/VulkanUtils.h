@@ -20,5 +20,7 @@ namespace vk::utils
 
     VkSampleCountFlagBits GetMaxUsableSampleCount(VkPhysicalDevice physicalDevice);
 
+    uint32_t GetIndexSize(VkIndexType indexType);
+
     VkShaderModule CreateShaderModule(VkDevice device, const std::filesystem::path& filepath);
 }
@@ -0,0 +1,4 @@
+#include <cstring>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>